@@ -0,0 +1,84 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include "metrics.hpp"
+
+// Early termination for runs whose CPI and mispredict rate have settled.
+//
+// The run is cut into batches of window/kBatches cycles and each batch mean is
+// treated as one sample (batch means, which absorbs the cycle-to-cycle
+// correlation). Over the last window (kBatches batches) the monitor computes a
+// 95% confidence interval for both metrics; the run has converged when
+//   * the CPI half-width is below eps * mean (relative) and the mispredict-rate
+//     half-width below eps (absolute, it is a fraction), and
+//   * the means of the last two windows differ by no more than the same bounds.
+// The achieved confidence is reported in Metrics::convergence.
+class ConvergenceMonitor {
+public:
+    static constexpr int kBatches = 10;
+
+    ConvergenceMonitor(double eps, uint64_t window) : eps_(eps) {
+        batch_ = window / kBatches ? window / kBatches : 1;
+        res_.enabled = true;
+        res_.batch_cycles = batch_;
+    }
+
+    // Call after every step; true once converged
+    bool sample(const Metrics& m) {
+        if (m.cycles - start_.cycles < batch_) return false;
+        Batch b;
+        const uint64_t retired = m.retired - start_.retired;
+        const uint64_t preds = m.bp_predictions - start_.bp_predictions;
+        b.cpi = retired ? double(m.cycles - start_.cycles) / double(retired) : double(m.cycles - start_.cycles);
+        b.mr = preds ? double(m.bp_mispredictions - start_.bp_mispredictions) / double(preds) : 0.0;
+        start_ = m;
+        hist_.push_back(b);
+        if (hist_.size() > 2 * kBatches) hist_.pop_front();
+        res_.batches++;
+        if (hist_.size() < 2 * kBatches) return false;
+
+        Window cur = window_stats(kBatches), prev = window_stats(0);
+        res_.cpi_mean = cur.cpi_mean;
+        res_.cpi_halfwidth = cur.cpi_hw;
+        res_.mispredict_rate = cur.mr_mean;
+        res_.mispredict_halfwidth = cur.mr_hw;
+        const double cpi_tol = eps_ * cur.cpi_mean;
+        if (cur.cpi_hw <= cpi_tol && cur.mr_hw <= eps_ &&
+            std::fabs(cur.cpi_mean - prev.cpi_mean) <= cpi_tol &&
+            std::fabs(cur.mr_mean - prev.mr_mean) <= eps_) {
+            res_.converged = true;
+            res_.at_cycle = m.cycles;
+        }
+        return res_.converged;
+    }
+
+    const ConvergenceStats& result() const { return res_; }
+
+private:
+    struct Batch { double cpi = 0, mr = 0; };
+    struct Window { double cpi_mean, cpi_hw, mr_mean, mr_hw; };
+
+    // Two-sided 95% Student t quantile for kBatches - 1 degrees of freedom
+    static constexpr double kT95 = 2.262;
+
+    Window window_stats(size_t first) const {
+        double sc = 0, sm = 0;
+        for (size_t i = first; i < first + kBatches; ++i) { sc += hist_[i].cpi; sm += hist_[i].mr; }
+        Window w{sc / kBatches, 0, sm / kBatches, 0};
+        double vc = 0, vm = 0;
+        for (size_t i = first; i < first + kBatches; ++i) {
+            vc += (hist_[i].cpi - w.cpi_mean) * (hist_[i].cpi - w.cpi_mean);
+            vm += (hist_[i].mr - w.mr_mean) * (hist_[i].mr - w.mr_mean);
+        }
+        w.cpi_hw = kT95 * std::sqrt(vc / (kBatches - 1) / kBatches);
+        w.mr_hw  = kT95 * std::sqrt(vm / (kBatches - 1) / kBatches);
+        return w;
+    }
+
+    double eps_;
+    uint64_t batch_;
+    Metrics start_;                // cumulative counters at the start of the open batch
+    std::deque<Batch> hist_;       // last two windows of batch means
+    ConvergenceStats res_;
+};
@@ -0,0 +1,117 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// L1 data cache: set-associative, LRU, write-allocate, tags only (the model
+// has no data values). Lines filled by wrong-path loads are marked until the
+// correct path first touches them, and the lines such fills evicted are
+// remembered in a small FIFO, so the two effects of wrong-path execution
+// can be told apart:
+//   prefetch : a correct-path access hits a line the wrong path brought in
+//   pollution: a correct-path access misses on a line a wrong-path fill evicted
+class DataCache {
+public:
+    static constexpr int kMaxLines = 1024;
+    static constexpr int kMaxWays = 16;
+    static constexpr int kLineBytes = 32;
+    static constexpr int kVictims = 64;   // one bit per slot in a uint64_t
+
+    enum class Result { Hit, Miss, PrefetchHit, PollutionMiss };
+
+    DataCache(int lines = 0, int ways = 2) {
+        ways_ = ways < 1 ? 1 : ways > kMaxWays ? kMaxWays : ways;
+        lines = lines < 0 ? 0 : lines > kMaxLines ? kMaxLines : lines;
+        sets_ = lines / ways_;
+        if (sets_ == 0 && lines > 0) { sets_ = 1; ways_ = lines; }
+    }
+
+    bool enabled() const { return sets_ > 0; }
+
+    // Would `addr` hit? (no side effects)
+    bool probe(int64_t addr) const {
+        const int64_t tag = line_of(addr);
+        const Line* set = &lines_[(size_t)set_of(tag) * ways_];
+        for (int w = 0; w < ways_; ++w)
+            if (set[w].valid && set[w].tag == tag) return true;
+        return false;
+    }
+
+    // Correct-path access (fills on a miss)
+    Result access(int64_t addr) {
+        const int64_t tag = line_of(addr);
+        Line* l = find(tag);
+        if (l) {
+            l->stamp = ++tick_;
+            const bool prefetched = l->wrong_path;
+            l->wrong_path = false;
+            return prefetched ? Result::PrefetchHit : Result::Hit;
+        }
+        fill(tag, false);
+        for (int i = 0; i < kVictims; ++i)
+            if (((victim_valid_ >> i) & 1) && victims_[i] == tag) {
+                victim_valid_ &= ~(1ull << i);
+                return Result::PollutionMiss;
+            }
+        return Result::Miss;
+    }
+
+    // Wrong-path access; returns true if it brought a line in
+    bool access_wrong_path(int64_t addr) {
+        const int64_t tag = line_of(addr);
+        if (Line* l = find(tag)) { l->stamp = ++tick_; return false; }
+        fill(tag, true);
+        return true;
+    }
+
+    // Valid lines as (slot << 1 | wrong-path flag, tag, age), then the victim FIFO (for state hashing)
+    template <typename F>
+    void for_each(F&& f) const {
+        for (int i = 0; i < sets_ * ways_; ++i)
+            if (lines_[i].valid)
+                f(((uint64_t)i << 1) | lines_[i].wrong_path, (uint64_t)lines_[i].tag, tick_ - lines_[i].stamp);
+        for (int i = 0; i < kVictims; ++i)
+            if ((victim_valid_ >> i) & 1) f((uint64_t)i, (uint64_t)victims_[i], 0);
+    }
+
+    static int64_t line_of(int64_t addr) {   // floor division: [r0-4] is in line -1
+        return addr >= 0 ? addr / kLineBytes : -((-addr + kLineBytes - 1) / kLineBytes);
+    }
+
+private:
+    struct Line {
+        int64_t tag = 0;
+        uint64_t stamp = 0;
+        bool valid = false;
+        bool wrong_path = false;   // filled by the wrong path, not yet used by the correct one
+    };
+
+    int set_of(int64_t tag) const { return (int)((uint64_t)tag % (uint64_t)sets_); }
+    Line* find(int64_t tag) {
+        Line* set = &lines_[(size_t)set_of(tag) * ways_];
+        for (int w = 0; w < ways_; ++w)
+            if (set[w].valid && set[w].tag == tag) return &set[w];
+        return nullptr;
+    }
+    void fill(int64_t tag, bool wrong_path) {
+        Line* set = &lines_[(size_t)set_of(tag) * ways_];
+        Line* victim = &set[0];
+        for (int w = 0; w < ways_; ++w) {
+            if (!set[w].valid) { victim = &set[w]; break; }
+            if (set[w].stamp < victim->stamp) victim = &set[w];
+        }
+        if (wrong_path && victim->valid) {
+            victims_[next_victim_] = victim->tag;
+            victim_valid_ |= 1ull << next_victim_;
+            next_victim_ = (next_victim_ + 1) % kVictims;
+        }
+        *victim = Line{tag, ++tick_, true, wrong_path};
+    }
+
+    std::array<Line, kMaxLines> lines_{};
+    std::array<int64_t, kVictims> victims_{};   // tags of lines evicted by wrong-path fills
+    uint64_t victim_valid_ = 0;                 // one bit per victims_ slot
+    int sets_ = 0;
+    int ways_ = 1;
+    int next_victim_ = 0;
+    uint64_t tick_ = 0;
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include "metrics.hpp"
+
+// Energy events. The simulator only counts them (Metrics already has a counter
+// for each, see energy_event_count); picojoules are applied once, at report time.
+enum class EnergyEvent : uint8_t {
+    Fetch,      // I-cache read: a fetch the loop buffer and micro-op cache missed, wrong path included
+    Decode,     // instruction decoded (not served by the micro-op cache or loop buffer)
+    UopRead,    // micro-op cache hit
+    LsdRead,    // loop buffer read
+    RegRead,    // register file read port use
+    RegWrite,   // register file write
+    Alu,        // ALU operation (arithmetic, compare, address generation)
+    L1d,        // L1 data access, --dcache or not (store buffer forwards excluded), wrong path included
+    L2,         // line fill from the next level
+    Tlb,        // L1 TLB lookup
+    WalkRef,    // page-table reference during a walk
+    Flush,      // mispredict recovery (squash, redirect)
+    Cycle,      // clock tree and leakage, per cycle
+    Count
+};
+constexpr int kNumEnergyEvents = (int)EnergyEvent::Count;
+
+inline const char* energy_event_name(EnergyEvent e) {
+    switch (e) {
+        case EnergyEvent::Fetch:    return "fetch";
+        case EnergyEvent::Decode:   return "decode";
+        case EnergyEvent::UopRead:  return "uop_read";
+        case EnergyEvent::LsdRead:  return "lsd_read";
+        case EnergyEvent::RegRead:  return "rf_read";
+        case EnergyEvent::RegWrite: return "rf_write";
+        case EnergyEvent::Alu:      return "alu";
+        case EnergyEvent::L1d:      return "l1d";
+        case EnergyEvent::L2:       return "l2";
+        case EnergyEvent::Tlb:      return "tlb";
+        case EnergyEvent::WalkRef:  return "walk_ref";
+        case EnergyEvent::Flush:    return "flush";
+        case EnergyEvent::Cycle:    return "cycle";
+        default:                    return "?";
+    }
+}
+
+uint64_t energy_event_count(const Metrics& m, EnergyEvent e);
+
+// Picojoules per event and the clock used to turn energy into power. The
+// defaults are rough 45 nm figures; --energy <file> replaces any of them.
+struct EnergyModel {
+    std::array<double, kNumEnergyEvents> pj{
+        20.0,   // fetch
+        5.0,    // decode
+        4.0,    // uop_read
+        1.0,    // lsd_read
+        1.5,    // rf_read
+        2.0,    // rf_write
+        0.5,    // alu
+        20.0,   // l1d
+        100.0,  // l2
+        2.0,    // tlb
+        20.0,   // walk_ref
+        10.0,   // flush
+        15.0,   // cycle
+    };
+    double clock_ghz = 1.0;
+};
+
+// "<event> = <pJ>" and "clock_ghz = <GHz>" lines; '#' starts a comment
+std::optional<std::string> load_energy_model(const std::string& path, EnergyModel& out);
+
+struct EnergyReport {
+    std::array<double, kNumEnergyEvents> pj{};   // per event kind
+    double total_pj = 0.0;
+    double epi_pj = 0.0;       // per retired instruction
+    double seconds = 0.0;      // cycles at the model's clock
+    double power_mw = 0.0;     // average
+};
+EnergyReport estimate_energy(const EnergyModel& model, const Metrics& m);
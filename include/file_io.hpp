@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Helpers for the files the simulator writes and reads itself: raw binary
+// fields (checkpoints, snapshots) and "<key> = <number>" model files.
+
+// --- Raw binary fields: host-endian, for a local cache, not an exchange format ---
+
+template <typename T>
+inline void put_raw(std::ostream& os, const T& v) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw field must be trivially copyable");
+    os.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+template <typename T>
+inline bool get_raw(std::istream& is, T& v) {
+    static_assert(std::is_trivially_copyable<T>::value, "raw field must be trivially copyable");
+    return (bool)is.read(reinterpret_cast<char*>(&v), sizeof(T));
+}
+
+// A vector as its length and then its elements' bytes (plain structs and pairs
+// of them); get_vec refuses more than kMaxRawVecBytes, so a corrupt file fails
+// instead of allocating without bound
+constexpr uint64_t kMaxRawVecBytes = 1ull << 30;
+
+template <typename T>
+inline void put_vec(std::ostream& os, const std::vector<T>& v) {
+    put_raw(os, (uint64_t)v.size());
+    os.write(reinterpret_cast<const char*>(v.data()), (std::streamsize)(v.size() * sizeof(T)));
+}
+template <typename T>
+inline bool get_vec(std::istream& is, std::vector<T>& v) {
+    uint64_t n = 0;
+    if (!get_raw(is, n) || n > kMaxRawVecBytes / sizeof(T)) return false;
+    v.resize(n);
+    return (bool)is.read(reinterpret_cast<char*>(v.data()), (std::streamsize)(n * sizeof(T)));
+}
+
+// --- "<key> = <number>" files ---
+
+inline std::string trim(const std::string& s) {
+    size_t a = s.find_first_not_of(" \t\r\n");
+    if (a == std::string::npos) return "";
+    size_t b = s.find_last_not_of(" \t\r\n");
+    return s.substr(a, b - a + 1);
+}
+
+// Reads "<key> = <non-negative number>" lines ('#' starts a comment) and passes
+// each to set(key, value), which returns an error for a key or value it rejects.
+// Errors carry "<path>:<line>: "; `what` names the file when it can't be opened.
+template <typename F>
+std::optional<std::string> load_key_values(const std::string& path, const std::string& what, F&& set) {
+    std::ifstream in(path);
+    if (!in) return "Cannot open " + what + ": " + path;
+    std::string line;
+    int lineno = 0;
+    while (std::getline(in, line)) {
+        ++lineno;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+        const size_t eq = line.find('=');
+        const std::string key = trim(line.substr(0, eq));
+        double v = 0.0;
+        std::istringstream val(eq == std::string::npos ? "" : line.substr(eq + 1));
+        std::optional<std::string> err;
+        if (!(val >> v) || v < 0.0) err = "expected <key> = <non-negative number>";
+        else err = set(key, v);
+        if (err) return path + ":" + std::to_string(lineno) + ": " + *err;
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <sstream>
+#include <string>
+#include "instr.hpp"
+
+// Macro-op fusion in decode: ID pairs the instruction it decodes with the next
+// one in the fetch stream and sends both down the pipeline in one slot.
+// Only dependent pairs fuse (the tail consumes the head's result):
+//   cmp-branch: SUB rd a b        + BEQ/BNE rd x imm   -> compare-and-branch
+//   alu-branch: ADD rd a b        + BEQ/BNE rd x imm   -> add-and-branch
+//   load-op   : LOAD rd [b+imm]   + ADD/SUB d rd x     -> load-op (d ready after MEM)
+enum class FusionRule : uint8_t { CmpBranch, AluBranch, LoadOp, Count };
+constexpr int kNumFusionRules = (int)FusionRule::Count;
+constexpr uint8_t kAllFusionRules = (1u << kNumFusionRules) - 1;
+
+inline const char* fusion_rule_name(FusionRule r) {
+    switch (r) {
+        case FusionRule::CmpBranch: return "cmp-branch";
+        case FusionRule::AluBranch: return "alu-branch";
+        case FusionRule::LoadOp:    return "load-op";
+        default:                    return "?";
+    }
+}
+
+// "none", "all" or a comma-separated list of rule names -> bitmask
+inline bool parse_fusion_rules(const std::string& s, uint8_t& out) {
+    if (s == "none") { out = 0; return true; }
+    if (s == "all")  { out = kAllFusionRules; return true; }
+    uint8_t mask = 0;
+    std::istringstream in(s);
+    std::string name;
+    while (std::getline(in, name, ',')) {
+        int r = 0;
+        while (r < kNumFusionRules && name != fusion_rule_name((FusionRule)r)) ++r;
+        if (r == kNumFusionRules) return false;
+        mask |= (uint8_t)(1u << r);
+    }
+    out = mask;
+    return mask != 0;
+}
+
+inline std::string fusion_rules_string(uint8_t mask) {
+    if (!mask) return "none";
+    std::string s;
+    for (int r = 0; r < kNumFusionRules; ++r)
+        if (mask & (1u << r)) s += (s.empty() ? "" : ",") + std::string(fusion_rule_name((FusionRule)r));
+    return s;
+}
+
+// Quick filter before fetching the would-be tail
+inline bool may_start_fusion(uint8_t rules, Opcode op) {
+    return (op == Opcode::SUB && (rules & (1u << (int)FusionRule::CmpBranch))) ||
+           (op == Opcode::ADD && (rules & (1u << (int)FusionRule::AluBranch))) ||
+           (op == Opcode::LOAD && (rules & (1u << (int)FusionRule::LoadOp)));
+}
+
+// Fuses `tail` (at head.pc + 1) into `head` if an enabled rule matches
+inline std::optional<FusionRule> try_fuse(uint8_t rules, Instruction& head, const Instruction& tail) {
+    if (head.fused || head.rd < 0 || !may_start_fusion(rules, head.op)) return std::nullopt;
+    // The tail's source that isn't the head's result (-1 if both are)
+    auto other_source = [&](int a, int b) { return a == head.rd ? (b == head.rd ? -1 : b) : a; };
+
+    FusionRule rule;
+    Instruction f = head;
+    if (head.op != Opcode::LOAD && (tail.op == Opcode::BEQ || tail.op == Opcode::BNE)) {
+        if (tail.rs1 != head.rd && tail.rs2 != head.rd) return std::nullopt;
+        rule = head.op == Opcode::SUB ? FusionRule::CmpBranch : FusionRule::AluBranch;
+        f.rs3 = other_source(tail.rs1, tail.rs2);
+        f.imm = tail.imm;   // branch displacement, relative to the tail
+    } else if (head.op == Opcode::LOAD && (tail.op == Opcode::ADD || tail.op == Opcode::SUB)) {
+        if (tail.rs1 != head.rd && tail.rs2 != head.rd) return std::nullopt;
+        rule = FusionRule::LoadOp;
+        f.rs3 = other_source(tail.rs1, tail.rs2);
+        f.rd2 = tail.rd;
+    } else {
+        return std::nullopt;
+    }
+    f.fused = true;
+    f.fused_op = tail.op;
+    head = f;
+    return rule;
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+#include "instr.hpp"
+
+// 64-bit FNV-1a over little-endian words; for content keys, not security
+constexpr uint64_t kHashSeed = 1469598103934665603ull;
+
+inline uint64_t hash_mix(uint64_t h, uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        h ^= (v >> (8 * i)) & 0xff;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// What an instruction does, independent of where it sits or when it was fetched
+inline uint64_t content_hash(const Instruction& ins) {
+    uint64_t h = kHashSeed;
+    h = hash_mix(h, (uint64_t)ins.op);
+    h = hash_mix(h, (uint64_t)(int64_t)ins.rd);
+    h = hash_mix(h, (uint64_t)(int64_t)ins.rs1);
+    h = hash_mix(h, (uint64_t)(int64_t)ins.rs2);
+    h = hash_mix(h, (uint64_t)(int64_t)ins.imm);
+    if (ins.fused) {
+        h = hash_mix(h, (uint64_t)ins.fused_op);
+        h = hash_mix(h, ((uint64_t)(uint32_t)ins.rs3 << 32) | (uint32_t)ins.rd2);
+    }
+    return h;
+}
@@ -1,19 +1,88 @@
 #pragma once
+#include <cstdint>
+#include <sstream>
+#include <string>
 #include "instr.hpp"
 
+// Bypass paths into the pipeline, named after the textbook 5-stage ones. Each
+// one can be left out (--bypass); a missing path turns into stall cycles.
+//   ex-ex  : EX/MEM register -> EX inputs (producer one ahead; also taps the
+//            ID branch comparator, see branch_in_id)
+//   mem-ex : MEM/WB register -> EX inputs (producer two ahead)
+//   wb-id  : write-first register file: ID reads a value WB writes this cycle
+//   mem-mem: MEM/WB register -> MEM, for a STORE's data (incl. a LOAD's result
+//            one ahead, which otherwise costs the load-use bubble)
+enum class BypassPath : uint8_t { ExEx, MemEx, WbId, MemMem, Count };
+constexpr int kNumBypassPaths = (int)BypassPath::Count;
+constexpr uint8_t kAllBypassPaths = (1u << kNumBypassPaths) - 1;
+// What forwarding ON has always meant
+constexpr uint8_t kDefaultBypassPaths = (1u << (int)BypassPath::ExEx) | (1u << (int)BypassPath::MemEx) |
+                                        (1u << (int)BypassPath::WbId);
+
+inline const char* bypass_path_name(BypassPath p) {
+    switch (p) {
+        case BypassPath::ExEx:   return "ex-ex";
+        case BypassPath::MemEx:  return "mem-ex";
+        case BypassPath::WbId:   return "wb-id";
+        case BypassPath::MemMem: return "mem-mem";
+        default:                 return "?";
+    }
+}
+
+// "none", "all" or a comma-separated list of path names -> bitmask
+inline bool parse_bypass_paths(const std::string& s, uint8_t& out) {
+    if (s == "none") { out = 0; return true; }
+    if (s == "all")  { out = kAllBypassPaths; return true; }
+    uint8_t mask = 0;
+    std::istringstream in(s);
+    std::string name;
+    while (std::getline(in, name, ',')) {
+        int p = 0;
+        while (p < kNumBypassPaths && name != bypass_path_name((BypassPath)p)) ++p;
+        if (p == kNumBypassPaths) return false;
+        mask |= (uint8_t)(1u << p);
+    }
+    out = mask;
+    return mask != 0;
+}
+
+inline std::string bypass_paths_string(uint8_t mask) {
+    if (!mask) return "none";
+    std::string s;
+    for (int p = 0; p < kNumBypassPaths; ++p)
+        if (mask & (1u << p)) s += (s.empty() ? "" : ",") + std::string(bypass_path_name((BypassPath)p));
+    return s;
+}
+
 // Decision for the ID stage this cycle.
 enum class HazardKind { None, RAW, WAR, WAW };
 
 struct HazardDecision {
     bool stall = false;        // if true, hold IF/ID and insert a bubble into ID/EX
     HazardKind kind = HazardKind::None;
+    bool load_use = false;     // RAW on a LOAD still in EX (the one bubble forwarding can't hide)
+    bool branch_operand = false;   // a branch resolving in ID waits for an operand (see branch_in_id)
+    uint8_t bypassed[kNumBypassPaths] = {};   // no stall: operands each path delivers
+    int missing_bypass = -1;   // stall: the disabled path that would have avoided it, or -1
 };
 
 // Compute hazards for the instruction currently in ID against producers ahead.
-// forwarding_on = true : allow EX/MEM and MEM/WB bypasses (but still handle load-use)
-// forwarding_on = false: require data to be available only after WB
+// bypass_paths         : BypassPath bitmask; 0 = data available only after WB
+// ex_load_early        : the LOAD in EX reads memory this cycle, so no load-use bubble
+// branch_in_id         : the instruction in ID is a branch compared in ID, which
+//                        needs its operands a stage earlier: forwarding reaches
+//                        ID only from MEM (ALU results, over ex-ex) and WB (wb-id), so a
+//                        producer in EX, or a LOAD in MEM that has not read
+//                        memory yet (mem_load_ready), stalls it
 HazardDecision detect_hazard_for_ID(const Instruction& id_ins, bool id_valid,
                                     const Instruction& ex_ins, bool ex_valid,
                                     const Instruction& mem_ins, bool mem_valid,
                                     const Instruction& wb_ins,  bool wb_valid,
-                                    bool forwarding_on);
+                                    uint8_t bypass_paths,
+                                    bool ex_load_early = false,
+                                    bool branch_in_id = false,
+                                    bool mem_load_ready = false);
+
+// Register file traffic of one pipeline slot (a fused slot counts both halves)
+int reg_reads(const Instruction& ins);
+int reg_writes(const Instruction& ins);
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Host hardware counters (Linux perf_event_open) for profiling the simulator itself.
+// Counters that can't be opened (no perf, paranoid settings, VM without PMU)
+// are simply reported as unavailable; wall time is always measured.
+enum class HostCounter { Cycles, Instructions, BranchMisses, LlcMisses, Count };
+constexpr int kNumHostCounters = (int)HostCounter::Count;
+
+const char* host_counter_name(HostCounter c);
+
+// Counter deltas for one measured phase
+struct HostPhase {
+    std::string name;
+    double   seconds = 0.0;
+    uint64_t value[kNumHostCounters] = {};
+    bool     valid[kNumHostCounters] = {};
+};
+
+class HostPerf {
+public:
+    // enabled = false: don't touch perf at all (phases still get wall time)
+    explicit HostPerf(bool enabled);
+    ~HostPerf();
+    HostPerf(const HostPerf&) = delete;
+    HostPerf& operator=(const HostPerf&) = delete;
+
+    // True if at least one hardware counter could be opened
+    bool available() const;
+    // Why counters are missing (empty if all opened)
+    const std::string& error() const { return error_; }
+
+    void start(const std::string& phase);
+    HostPhase stop();
+
+private:
+    int fd_[kNumHostCounters];
+    std::string error_;
+    HostPhase cur_;
+    int64_t t0_ns_ = 0;
+};
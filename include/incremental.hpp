@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <string>
+#include "instr_source.hpp"
+#include "metrics.hpp"
+#include "predictor.hpp"
+#include "pipeline.hpp"
+
+// Incremental re-simulation against a cache of an earlier run of (nearly) the same trace.
+//
+// Each run leaves in `dir` an index plus pipeline/predictor checkpoints every
+// `every` cycles. A checkpoint is keyed by the hash of the program prefix up to
+// the highest PC fetched before it, so it stays valid for any trace that only
+// differs after that PC. On the next run:
+//   * the first edited PC (within what the cached run fetched) is found;
+//   * the run resumes from the last checkpoint that never fetched it;
+//   * from then on the pipeline state hash is compared every cycle with the
+//     cached checkpoints; once it matches one after which the cached run never
+//     fetched an edited PC, the cached suffix metrics are spliced on and
+//     simulation stops (timing shifts from the edit are allowed).
+// Only metrics are produced (no timeline). The cache is rewritten after runs
+// that simulate to the end.
+struct IncrementalConfig {
+    std::string dir;
+    uint64_t every = 10000;
+    uint64_t max_cycles = 0;
+    PipelineConfig pipeline;
+    std::string predictor;
+};
+
+struct IncrementalResult {
+    Metrics metrics;
+    bool cache_hit = false;        // a usable cache existed
+    int first_edit = -1;           // first PC that differs from the cached trace (-1: none fetched)
+    uint64_t resumed_at = 0;       // cycle simulation restarted from
+    bool spliced = false;          // reconverged with the cached run
+    uint64_t spliced_at = 0;
+    uint64_t simulated = 0;        // cycles actually simulated
+};
+
+std::optional<std::string> run_incremental(const InstructionSource& prog, BranchPredictor& bp,
+                                           const IncrementalConfig& cfg, IncrementalResult& out);
@@ -10,7 +10,10 @@ enum class Opcode {
     BEQ,    // BEQ  rs1 rs2 imm   (PC-relative offset, in instructions)
     BNE,    // BNE  rs1 rs2 imm
     NOP,    // NOP
-    HALT    // HALT
+    HALT,   // HALT
+    JAL,    // JAL  rd imm        (rd <- PC+1; jump PC-relative like BEQ/BNE)
+    JALR,   // JALR rd rs1 imm    (rd <- PC+1; jump to rs1 + imm)
+    DIV     // DIV  rd rs1 rs2    (iterative divider: keeps EX for div_cycles)
 };
 
 // Toy ISA register file size (can change later)
@@ -26,6 +29,29 @@ struct Instruction {
     int    id   = -1;   // globally unique instruction id (for timeline)
     int    pc   = -1;   // index in the trace (0-based)
 
+    // Macro-op fusion (see fusion.hpp): this slot also carries the instruction
+    // at pc+1, of type fused_op. rs3 is that one's source not produced here,
+    // rd2 its destination if it has its own.
+    bool   fused = false;
+    Opcode fused_op = Opcode::NOP;
+    int    rs3  = -1;
+    int    rd2  = -1;
+
+    // Timing stamps, filled in by the pipeline as the instruction flows
+    uint64_t t_fetch = 0;   // cycle it entered IF
+    uint32_t d_id  = 0;     // cycles after t_fetch it entered ID
+    uint32_t d_ex  = 0;     //   ... EX
+    uint32_t d_mem = 0;     //   ... MEM
+
     // Human-readable (for debugging & CSV)
     std::string to_string() const;
 };
+
+// Calls and returns follow the RISC-V hints: r1 and r5 are link registers; a
+// JAL/JALR writing one is a call, a JALR reading one and writing r0 a return.
+inline bool is_link_reg(int r) { return r == 1 || r == 5; }
+inline bool is_jump(const Instruction& ins) { return ins.op == Opcode::JAL || ins.op == Opcode::JALR; }
+inline bool is_call(const Instruction& ins) { return is_jump(ins) && is_link_reg(ins.rd); }
+inline bool is_return(const Instruction& ins) {
+    return ins.op == Opcode::JALR && ins.rd == 0 && is_link_reg(ins.rs1);
+}
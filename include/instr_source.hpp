@@ -0,0 +1,27 @@
+#pragma once
+#include <vector>
+#include "instr.hpp"
+
+// Where the pipeline fetches instructions from.
+// A source exposes a flat PC space [0, size()); how the instructions behind it
+// are stored (plain vector, REPEAT blocks expanded on demand, ...) is up to it.
+class InstructionSource {
+public:
+    virtual ~InstructionSource() = default;
+
+    // Number of addressable PCs
+    virtual int size() const = 0;
+
+    // Instruction at pc (0 <= pc < size()); id/pc fields are filled in
+    virtual Instruction at(int pc) const = 0;
+};
+
+// Source over an already materialised program (not owned)
+class VectorSource : public InstructionSource {
+public:
+    explicit VectorSource(const std::vector<Instruction>& prog) : prog_(prog) {}
+    int size() const override { return (int)prog_.size(); }
+    Instruction at(int pc) const override { return prog_[pc]; }
+private:
+    const std::vector<Instruction>& prog_;
+};
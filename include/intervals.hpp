@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "metrics.hpp"
+
+// Counters for one interval of the run (deltas of the cumulative Metrics)
+struct IntervalSample {
+    uint64_t start_cycle = 0;
+    uint64_t cycles = 0;
+    uint64_t retired = 0;
+    uint64_t bp_predictions = 0;
+    uint64_t bp_mispredictions = 0;
+    CpiStack cpi_stack;
+
+    double cpi() const { return retired ? double(cycles) / double(retired) : 0.0; }
+};
+
+// Cuts the run into fixed-length intervals (every == 0: one interval for the whole run).
+// Call sample() after every Pipeline::step() and finish() once at the end.
+class IntervalRecorder {
+public:
+    explicit IntervalRecorder(uint64_t every = 0) : every_(every) {}
+
+    void sample(const Metrics& m) {
+        if (every_ && m.cycles - prev_.start_cycle >= every_) close(m);
+    }
+    void finish(const Metrics& m) {
+        if (m.cycles > prev_.start_cycle) close(m);
+    }
+
+    const std::vector<IntervalSample>& samples() const { return out_; }
+
+private:
+    void close(const Metrics& m) {
+        IntervalSample d;
+        d.start_cycle       = prev_.start_cycle;
+        d.cycles            = m.cycles - prev_.start_cycle;
+        d.retired           = m.retired - prev_.retired;
+        d.bp_predictions    = m.bp_predictions - prev_.bp_predictions;
+        d.bp_mispredictions = m.bp_mispredictions - prev_.bp_mispredictions;
+        for (int c = 0; c < kNumCpiComponents; ++c)
+            d.cpi_stack.cycles[c] = m.cpi_stack.cycles[c] - prev_.cpi_stack.cycles[c];
+        out_.push_back(d);
+
+        // prev_ holds the cumulative counters at the start of the next interval
+        prev_.start_cycle       = m.cycles;
+        prev_.retired           = m.retired;
+        prev_.bp_predictions    = m.bp_predictions;
+        prev_.bp_mispredictions = m.bp_mispredictions;
+        prev_.cpi_stack         = m.cpi_stack;
+    }
+
+    uint64_t every_;
+    IntervalSample prev_;
+    std::vector<IntervalSample> out_;
+};
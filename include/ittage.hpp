@@ -0,0 +1,217 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include "predictor.hpp"
+
+// Target predictor for indirect jumps (JALR other than returns)
+enum class IndirectMode : uint8_t {
+    None,     // no target prediction: fetch falls through until EX
+    Btb,      // last target per PC (the ITTAGE base table alone)
+    Ittage,   // base table + tagged, history-indexed tables
+};
+
+inline const char* indirect_mode_name(IndirectMode m) {
+    switch (m) {
+        case IndirectMode::None:   return "none";
+        case IndirectMode::Btb:    return "btb";
+        case IndirectMode::Ittage: return "ittage";
+    }
+    return "?";
+}
+
+inline bool parse_indirect_mode(const std::string& s, IndirectMode& out) {
+    for (IndirectMode m : {IndirectMode::None, IndirectMode::Btb, IndirectMode::Ittage})
+        if (s == indirect_mode_name(m)) { out = m; return true; }
+    return false;
+}
+
+// ITTAGE-style indirect target predictor (Seznec), in flat fixed-size tables.
+//
+//   base : PC-indexed, untagged {target, confidence}
+//   T1-T4: indexed and tagged by PC hashed with the last 4/9/20/44 bits of
+//          global history (branch directions and jump target bits)
+//
+// The longest-history table that hits provides the target, unless its
+// confidence is zero, in which case the next hit (or the base) does. A wrong
+// target allocates an entry in a longer table whose useful counter is zero.
+// History is updated at resolution; EX resolves every older control
+// instruction before the next one predicts, so it is never speculative here.
+class IttagePredictor {
+public:
+    static constexpr int kTables = 4;
+    static constexpr int kLogBase = 9;
+    static constexpr int kLogTagged = 8;
+    static constexpr int kTagBits = 9;
+
+    explicit IttagePredictor(IndirectMode mode = IndirectMode::Ittage) : mode_(mode) {}
+
+    // Predicted target of the indirect jump at `pc`, or `fallback` if there is none
+    int predict(int pc, int fallback) const {
+        if (mode_ == IndirectMode::None) return fallback;
+        const int t = choose(lookup(pc), pc);
+        return t >= 0 ? t : fallback;
+    }
+
+    // Train with the resolved target of the indirect jump at `pc`
+    void update(int pc, int target) {
+        if (mode_ != IndirectMode::None && target >= 0) {
+            trained_ = true;
+            const Lookup l = lookup(pc);
+            if (mode_ == IndirectMode::Ittage) train_tagged(l, pc, target);
+            Base& b = base_[pc_index(pc)];
+            if (b.valid && b.target == target) { if (b.ctr < 3) b.ctr++; }
+            else if (b.valid && b.ctr > 0) b.ctr--;
+            else b = Base{target, 0, 1};
+        }
+        push_target(target);
+    }
+
+    // Every other resolved control instruction feeds the history too
+    void push_branch(bool taken) { ghist_ = (ghist_ << 1) | (uint64_t)taken; }
+    void push_target(int target) {
+        ghist_ = (ghist_ << 2) | (uint64_t)((target ^ (target >> 2)) & 3);
+    }
+
+    // History and valid entries (for state hashing; tables are skipped until trained)
+    template <typename F>
+    void for_each(F&& f) const {
+        if (mode_ == IndirectMode::None) return;
+        f(ghist_);
+        if (!trained_) return;
+        for (int i = 0; i < (1 << kLogBase); ++i)
+            if (base_[i].valid) f(((uint64_t)i << 40) | ((uint64_t)base_[i].ctr << 32) | (uint32_t)base_[i].target);
+        for (int t = 0; t < kTables; ++t)
+            for (int i = 0; i < (1 << kLogTagged); ++i) {
+                const Tagged& e = tagged_[t][i];
+                if (!e.valid) continue;
+                f(((uint64_t)t << 56) | ((uint64_t)i << 40) | ((uint64_t)e.tag << 24) |
+                  ((uint64_t)e.ctr << 20) | ((uint64_t)e.useful << 16));
+                f((uint32_t)e.target);
+            }
+    }
+
+    // History and valid entries as PredictorState pairs, for snapshot deltas. Tables
+    // are numbered from `first`: the base, then T1-T4, then the history (index 0).
+    void save_tables(PredictorState& out, uint32_t first) const {
+        if (mode_ == IndirectMode::None) return;
+        auto key = [&](int table, int i) { return ((uint64_t)(first + table) << 32) | (uint32_t)i; };
+        out.emplace_back(key(kTables + 1, 0), (int64_t)ghist_);
+        if (!trained_) return;
+        for (int i = 0; i < (1 << kLogBase); ++i)
+            if (base_[i].valid)
+                out.emplace_back(key(0, i), (int64_t)(((uint64_t)base_[i].ctr << 32) | (uint32_t)base_[i].target));
+        for (int t = 0; t < kTables; ++t)
+            for (int i = 0; i < (1 << kLogTagged); ++i) {
+                const Tagged& e = tagged_[t][i];
+                if (e.valid)
+                    out.emplace_back(key(t + 1, i), (int64_t)(((uint64_t)e.useful << 56) | ((uint64_t)e.ctr << 48) |
+                                                              ((uint64_t)e.tag << 32) | (uint32_t)e.target));
+            }
+    }
+    void load_tables(const PredictorState& in, uint32_t first) {
+        if (mode_ == IndirectMode::None) return;
+        base_ = {};
+        tagged_ = {};
+        trained_ = false;
+        for (const auto& [k, v] : in) {
+            const uint32_t table = (uint32_t)(k >> 32) - first;
+            const int i = (int)(uint32_t)k;
+            const uint64_t u = (uint64_t)v;
+            if (table == (uint32_t)kTables + 1) {
+                ghist_ = u;
+            } else if (table == 0) {
+                base_[i] = Base{(int32_t)(uint32_t)u, (uint8_t)(u >> 32), 1};
+                trained_ = true;
+            } else if (table <= (uint32_t)kTables) {
+                tagged_[table - 1][i] = Tagged{(int32_t)(uint32_t)u, (uint16_t)(u >> 32), (uint8_t)((u >> 48) & 0xff),
+                                               (uint8_t)(u >> 56), 1};
+                trained_ = true;
+            }
+        }
+    }
+
+private:
+    struct Base   { int32_t target = 0; uint8_t ctr = 0; uint8_t valid = 0; };
+    struct Tagged { int32_t target = 0; uint16_t tag = 0; uint8_t ctr = 0; uint8_t useful = 0; uint8_t valid = 0; };
+    struct Lookup {
+        int idx[kTables];
+        uint16_t tag[kTables];
+        int provider = -1;   // longest hitting table
+        int alt = -1;        // next longest hitting table (-1: base)
+    };
+
+    static constexpr int kHistLen[kTables] = {4, 9, 20, 44};
+
+    // XOR-fold the last `len` history bits down to `bits`
+    uint32_t fold(int len, int bits) const {
+        uint64_t h = len >= 64 ? ghist_ : ghist_ & ((1ull << len) - 1);
+        uint32_t r = 0;
+        for (; h; h >>= bits) r ^= (uint32_t)(h & ((1u << bits) - 1));
+        return r;
+    }
+    static int pc_index(int pc) { return (int)((uint32_t)pc & ((1u << kLogBase) - 1)); }
+
+    Lookup lookup(int pc) const {
+        Lookup l;
+        const uint32_t p = (uint32_t)pc;
+        for (int t = 0; t < kTables; ++t) {
+            l.idx[t] = (int)((p ^ (p >> kLogTagged) ^ fold(kHistLen[t], kLogTagged)) & ((1u << kLogTagged) - 1));
+            l.tag[t] = (uint16_t)((p ^ fold(kHistLen[t], kTagBits) ^ (fold(kHistLen[t], kTagBits - 1) << 1)) &
+                                  ((1u << kTagBits) - 1));
+        }
+        if (mode_ != IndirectMode::Ittage) return l;
+        for (int t = kTables - 1; t >= 0; --t) {
+            const Tagged& e = tagged_[t][l.idx[t]];
+            if (!e.valid || e.tag != l.tag[t]) continue;
+            if (l.provider < 0) l.provider = t;
+            else { l.alt = t; break; }
+        }
+        return l;
+    }
+
+    int base_target(int pc) const {
+        const Base& b = base_[pc_index(pc)];
+        return b.valid ? b.target : -1;
+    }
+    // Alternative prediction: the next hitting table, else the base (-1: none)
+    int alt_target(const Lookup& l, int pc) const {
+        return l.alt >= 0 ? tagged_[l.alt][l.idx[l.alt]].target : base_target(pc);
+    }
+    // Final prediction (-1: none)
+    int choose(const Lookup& l, int pc) const {
+        if (l.provider < 0) return base_target(pc);
+        const Tagged& e = tagged_[l.provider][l.idx[l.provider]];
+        const int alt = alt_target(l, pc);
+        return e.ctr > 0 || alt < 0 ? e.target : alt;
+    }
+
+    void train_tagged(const Lookup& l, int pc, int target) {
+        const int pred = choose(l, pc);
+        if (l.provider >= 0) {
+            Tagged& e = tagged_[l.provider][l.idx[l.provider]];
+            const bool hit = e.target == target;
+            if (hit != (alt_target(l, pc) == target))
+                e.useful = hit ? (uint8_t)(e.useful < 3 ? e.useful + 1 : 3)
+                               : (uint8_t)(e.useful > 0 ? e.useful - 1 : 0);
+            if (hit) { if (e.ctr < 3) e.ctr++; }
+            else if (e.ctr > 0) e.ctr--;
+            else e.target = target;
+        }
+        if (pred == target) return;
+        // Allocate in a longer table; if none is free, age their useful counters
+        for (int t = l.provider + 1; t < kTables; ++t) {
+            Tagged& e = tagged_[t][l.idx[t]];
+            if (e.valid && e.useful > 0) continue;
+            e = Tagged{target, l.tag[t], 0, 0, 1};
+            return;
+        }
+        for (int t = l.provider + 1; t < kTables; ++t) tagged_[t][l.idx[t]].useful--;
+    }
+
+    IndirectMode mode_;
+    bool trained_ = false;
+    uint64_t ghist_ = 0;
+    std::array<Base, 1 << kLogBase> base_{};
+    std::array<std::array<Tagged, 1 << kLogTagged>, kTables> tagged_{};
+};
@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "pipeline.hpp"
+#include "intervals.hpp"
+
+// Single-producer / single-consumer ring; push never blocks (returns false when full)
+template <typename T, size_t N>
+class SpscRing {
+public:
+    bool push(const T& v) {
+        uint64_t h = head_.load(std::memory_order_relaxed);
+        if (h - tail_.load(std::memory_order_acquire) >= N) return false;
+        buf_[h % N] = v;
+        head_.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    bool pop(T& v) {
+        uint64_t t = tail_.load(std::memory_order_relaxed);
+        if (t == head_.load(std::memory_order_acquire)) return false;
+        v = buf_[t % N];
+        tail_.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    size_t size() const {
+        return (size_t)(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+    }
+    static constexpr size_t capacity() { return N; }
+
+private:
+    std::array<T, N> buf_{};
+    std::atomic<uint64_t> head_{0};
+    std::atomic<uint64_t> tail_{0};
+};
+
+// Localhost HTTP/WebSocket server that streams the timeline while the simulation runs.
+//
+// The simulation thread only calls publish_*(), which never block: rows go into a
+// lock-free ring drained by the server thread. When the client (or socket) can't
+// keep up, the ring fills and publish_row() falls back to sampling every k-th row
+// (k doubles under pressure and halves again when the ring drains).
+//
+// Wire format (little-endian WebSocket binary messages):
+//   rows:     u8 type=1, u8 pad, u16 count, u32 stride,
+//             count * { u64 cycle, 5 * { u8 kind, u8 code, i32 id } }
+//   interval: u8 type=2, u8 pad[7], u64 start_cycle, cycles, retired,
+//             bp_predictions, bp_mispredictions, u64 cpi_stack[kNumCpiComponents]
+//   done:     u8 type=3, u8 pad[7], u64 dropped_rows, u64 sampled_out_rows
+// Any non-WebSocket GET returns a small JSON status.
+class LiveServer {
+public:
+    LiveServer() = default;
+    ~LiveServer();
+    LiveServer(const LiveServer&) = delete;
+    LiveServer& operator=(const LiveServer&) = delete;
+
+    // Bind 127.0.0.1:port and start the server thread; returns error text on failure
+    std::string start(int port);
+    // Block until a WebSocket client has connected
+    void wait_for_client() const;
+    // Mark the stream finished, give the client up to `drain_ms` to catch up, stop
+    void finish(int drain_ms = 2000);
+
+    // --- producer side (simulation thread) ---
+    void publish_row(const TimelineRow& row);
+    void publish_interval(const IntervalSample& iv);
+
+    uint64_t dropped_rows() const { return dropped_.load(); }
+    uint64_t sampled_out_rows() const { return sampled_out_.load(); }
+
+private:
+    static constexpr size_t kRowRing = 1 << 14;
+    static constexpr size_t kIntervalRing = 1 << 10;
+    static constexpr uint32_t kMaxStride = 1 << 12;
+
+    void run();
+
+    SpscRing<TimelineRow, kRowRing> rows_;
+    SpscRing<IntervalSample, kIntervalRing> intervals_;
+
+    // producer-only sampling state
+    uint32_t stride_ = 1;
+    uint64_t seq_ = 0;
+
+    std::atomic<uint32_t> cur_stride_{1};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> sampled_out_{0};
+    std::atomic<uint64_t> last_cycle_{0};
+    std::atomic<bool> running_{false};
+    std::atomic<bool> finished_{false};
+    std::atomic<bool> finished_sent_{false};
+    std::atomic<bool> client_{false};
+
+    int listen_fd_ = -1;
+    std::thread thread_;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "instr.hpp"
+
+// Loop stream detector: finds a short loop in the decoded stream and replays
+// it to ID, so fetch and decode can idle while the loop runs.
+//
+// A predicted-taken backward branch whose body [target, branch] fits in the
+// buffer becomes the candidate, and the decoded instructions of its body are
+// captured as they go by. Once the same branch has closed the loop
+// kLockIterations times with every body slot captured, the detector locks and
+// supplies each fetch inside the body. The first fetch outside it (loop exit,
+// redirect elsewhere) unlocks, and detection starts over.
+class LoopStreamDetector {
+public:
+    static constexpr int kMaxEntries = 64;   // one capture bit per entry in a uint64_t
+    static constexpr int kLockIterations = 2;
+
+    explicit LoopStreamDetector(int entries = 0)
+    : cap_(entries < 0 ? 0 : entries > kMaxEntries ? kMaxEntries : entries) {}
+
+    bool enabled() const { return cap_ > 0; }
+    bool locked() const { return locked_; }
+
+    // Predicted-taken control transfer from `pc` to `target`, seen at ID.
+    // Returns true if it locked the loop.
+    bool taken(int pc, int target) {
+        if (!enabled() || locked_) return false;
+        if (pc == end_ && target == start_) {
+            if (++closes_ >= kLockIterations && captured_ == full_mask()) locked_ = true;
+            return locked_;
+        }
+        if (target <= pc && pc - target < cap_) {
+            start_ = target;
+            end_ = pc;
+            closes_ = 1;
+            captured_ = 0;
+        } else if (!in_body(pc) || !in_body(target)) {
+            start_ = end_ = -1;   // left the candidate loop
+        }
+        return false;
+    }
+
+    // Decoded instruction delivered by fetch (kept if it is in the candidate body)
+    void capture(const Instruction& ins) {
+        if (locked_ || !in_body(ins.pc)) return;
+        buf_[ins.pc - start_] = ins;
+        captured_ |= 1ull << (ins.pc - start_);
+    }
+
+    // Decoded instruction at `pc` while streaming (nullptr: not streaming).
+    // A fetch outside the locked body unlocks.
+    const Instruction* lookup(int pc) {
+        if (!locked_) return nullptr;
+        if (in_body(pc)) return &buf_[pc - start_];
+        locked_ = false;
+        start_ = end_ = -1;
+        return nullptr;
+    }
+    bool covers(int pc) const { return locked_ && in_body(pc); }
+
+    // Candidate/locked loop and its capture state (for state hashing)
+    template <typename F>
+    void for_each(F&& f) const {
+        f(((uint64_t)(uint32_t)start_ << 32) | (uint32_t)end_);
+        f(((uint64_t)closes_ << 1) | locked_);
+        f(captured_);
+    }
+
+private:
+    bool in_body(int pc) const { return start_ >= 0 && pc >= start_ && pc <= end_; }
+    uint64_t full_mask() const {
+        const int n = end_ - start_ + 1;
+        return n >= 64 ? ~0ull : (1ull << n) - 1;
+    }
+
+    std::array<Instruction, kMaxEntries> buf_{};
+    int start_ = -1;
+    int end_ = -1;
+    uint32_t closes_ = 0;
+    uint64_t captured_ = 0;
+    bool locked_ = false;
+    int cap_;
+};
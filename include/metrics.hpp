@@ -1,12 +1,285 @@
 #pragma once
+#include <array>
 #include <cstdint>
+#include "instr.hpp"
+#include "fusion.hpp"
+#include "hazard.hpp"
 
 struct StallBreakdown {
     uint64_t raw = 0;       // Read-After-Write
     uint64_t war = 0;       // Write-After-Read (kept for completeness)
     uint64_t waw = 0;       // Write-After-Write (kept for completeness)
     uint64_t control = 0;   // branch-related flush bubbles
-    uint64_t total() const { return raw + war + waw + control; }
+    uint64_t sb_full = 0;       // STORE held in MEM: store buffer full (structural)
+    uint64_t stlf_partial = 0;  // LOAD held in MEM: partly overlaps a buffered store
+    uint64_t dcache_miss = 0;   // LOAD held in MEM: D-cache miss (--dcache)
+    uint64_t itlb_miss = 0;     // fetch bubbles waiting for an instruction translation
+    uint64_t dtlb_miss = 0;     // LOAD/STORE held in MEM waiting for a data translation
+    uint64_t structural = 0;    // ID or IF waiting for a busy resource (see ResourceStats)
+    uint64_t total() const {
+        return raw + war + waw + control + sb_full + stlf_partial + dcache_miss + itlb_miss + dtlb_miss +
+               structural;
+    }
+};
+
+// Log-bucketed (HDR-style) histogram of cycle counts.
+// Each power-of-two range is split into kSub linear sub-buckets, so the
+// relative error of a reported percentile is bounded by 1/kSub. Fixed storage.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBits = 2;
+    static constexpr int kSub     = 1 << kSubBits;
+    static constexpr int kBuckets = (64 - kSubBits + 1) * kSub;
+
+    void record(uint64_t v) {
+        counts_[bucket_of(v)]++;
+        n_++;
+        if (v > max_) max_ = v;
+    }
+
+    uint64_t count() const { return n_; }
+    uint64_t max()   const { return max_; }
+
+    // Add the samples recorded between two snapshots of another histogram
+    // (`to` taken after `from`). The max can't be un-merged, so `to.max()` is
+    // kept as an upper bound.
+    void add_delta(const LatencyHistogram& to, const LatencyHistogram& from) {
+        for (int b = 0; b < kBuckets; ++b) counts_[b] += to.counts_[b] - from.counts_[b];
+        n_ += to.n_ - from.n_;
+        if (to.n_ != from.n_ && to.max_ > max_) max_ = to.max_;
+    }
+
+    // Smallest bucket upper bound covering fraction p (0..1) of samples
+    uint64_t percentile(double p) const {
+        if (n_ == 0) return 0;
+        uint64_t want = (uint64_t)(p * (double)n_ + 0.5);
+        if (want == 0) want = 1;
+        uint64_t seen = 0;
+        for (int b = 0; b < kBuckets; ++b) {
+            seen += counts_[b];
+            if (seen >= want) return upper_of(b) < max_ ? upper_of(b) : max_;
+        }
+        return max_;
+    }
+
+private:
+    static int bucket_of(uint64_t v) {
+        if (v < (uint64_t)kSub) return (int)v;
+        int e = kSubBits;                                // floor(log2 v)
+        while (e < 63 && (v >> (e + 1)) != 0) ++e;
+        int sub = (int)((v >> (e - kSubBits)) & (kSub - 1));
+        return (e - kSubBits + 1) * kSub + sub;
+    }
+    static uint64_t upper_of(int b) {
+        if (b < kSub) return (uint64_t)b;
+        int e = b / kSub - 1 + kSubBits;
+        uint64_t sub = (uint64_t)(b % kSub);
+        uint64_t lo = (1ull << e) | (sub << (e - kSubBits));
+        return lo + (1ull << (e - kSubBits)) - 1;
+    }
+
+    std::array<uint64_t, kBuckets> counts_{};
+    uint64_t n_ = 0;
+    uint64_t max_ = 0;
+};
+
+// Opcode classes used for latency reporting
+enum class OpClass { ALU, Load, Store, Branch, Count };
+constexpr int kNumOpClasses = (int)OpClass::Count;
+
+inline OpClass op_class(Opcode op) {
+    switch (op) {
+        case Opcode::LOAD:  return OpClass::Load;
+        case Opcode::STORE: return OpClass::Store;
+        case Opcode::BEQ:
+        case Opcode::BNE:
+        case Opcode::JAL:
+        case Opcode::JALR:  return OpClass::Branch;
+        default:            return OpClass::ALU;
+    }
+}
+inline const char* op_class_name(OpClass c) {
+    switch (c) {
+        case OpClass::ALU:    return "ALU";
+        case OpClass::Load:   return "LOAD";
+        case OpClass::Store:  return "STORE";
+        case OpClass::Branch: return "BRANCH";
+        default:              return "?";
+    }
+}
+
+// Stages whose residency is tracked (WB is always one cycle)
+enum class StageId { IF, ID, EX, MEM, Count };
+constexpr int kNumTrackedStages = (int)StageId::Count;
+
+// Per-instruction latency distributions, per opcode class
+struct LatencyStats {
+    LatencyHistogram total[kNumOpClasses];                       // fetch -> retire, inclusive
+    LatencyHistogram stage[kNumOpClasses][kNumTrackedStages];    // cycles spent in each stage
+};
+
+// CPI stack: every cycle is charged to exactly one component, decided by what
+// the WB slot holds that cycle (an instruction -> Base, a bubble -> its cause).
+enum class CpiComponent { Base, Raw, LoadUse, Control, Fetch, Structural, Memory, Count };
+constexpr int kNumCpiComponents = (int)CpiComponent::Count;
+
+inline const char* cpi_component_name(CpiComponent c) {
+    switch (c) {
+        case CpiComponent::Base:       return "base";
+        case CpiComponent::Raw:        return "raw";
+        case CpiComponent::LoadUse:    return "load_use";
+        case CpiComponent::Control:    return "control";
+        case CpiComponent::Fetch:      return "fetch";
+        case CpiComponent::Structural: return "structural";
+        case CpiComponent::Memory:     return "memory";
+        default:                       return "?";
+    }
+}
+
+struct CpiStack {
+    std::array<uint64_t, kNumCpiComponents> cycles{};
+    uint64_t& operator[](CpiComponent c) { return cycles[(int)c]; }
+    uint64_t  operator[](CpiComponent c) const { return cycles[(int)c]; }
+    uint64_t total() const {
+        uint64_t t = 0;
+        for (uint64_t v : cycles) t += v;
+        return t;
+    }
+};
+
+// Outcome of --converge (see ConvergenceMonitor); half-widths are 95% confidence
+struct ConvergenceStats {
+    bool enabled = false;
+    bool converged = false;
+    uint64_t at_cycle = 0;
+    uint64_t batches = 0;
+    uint64_t batch_cycles = 0;
+    double cpi_mean = 0.0, cpi_halfwidth = 0.0;
+    double mispredict_rate = 0.0, mispredict_halfwidth = 0.0;
+};
+
+// Data-side memory traffic
+struct MemoryStats {
+    uint64_t loads = 0;
+    uint64_t stores = 0;
+    uint64_t stlf_forwards = 0;  // loads served from the store buffer
+
+    // Early loads (--early-loads)
+    uint64_t early_loads = 0;         // loads that read memory in EX
+    uint64_t held_loads = 0;          // predicted dependent, waited for MEM
+    uint64_t false_dependences = 0;   // ... although no overlapping store was in flight
+    uint64_t order_violations = 0;    // early load overlapped the store in MEM -> replay
+    uint64_t replay_bubbles = 0;      // cycles lost to replays
+
+    // L1 data cache (--dcache), correct path only
+    uint64_t dcache_accesses = 0;
+    uint64_t dcache_misses = 0;
+};
+
+// Execution down the predicted path after a mispredict (--wrong-path)
+struct WrongPathStats {
+    uint64_t instructions = 0;      // fetched on the wrong path (incl. the one squashed in ID)
+    uint64_t loads = 0;             // wrong-path loads (each reads the L1d, modelled with --dcache or not)
+    uint64_t fills = 0;             // ... that brought a line into the --dcache
+    uint64_t prefetch_hits = 0;     // correct-path hits on a line a wrong-path load brought in
+    uint64_t pollution_misses = 0;  // correct-path misses on a line a wrong-path fill evicted
+};
+
+// Calls, returns and the return address stack
+struct CallStats {
+    uint64_t calls = 0;
+    uint64_t returns = 0;
+    uint64_t ras_overflows = 0;       // push onto a full RAS dropped the oldest entry
+    uint64_t ras_underflows = 0;      // return found the RAS empty
+    uint64_t return_mispredicts = 0;  // RAS target wrong (incl. underflows)
+};
+
+// Macro-op fusion (--fusion)
+struct FusionStats {
+    uint64_t pairs = 0;                                 // fused slots (2 instructions each)
+    std::array<uint64_t, kNumFusionRules> by_rule{};
+    double baseline_cpi = 0.0;      // same run without fusion, filled in by the driver (0: not run)
+};
+
+// Structural resources (--mem-ports, --rf-ports, --div-cycles): stall cycles
+// per resource, adding up to stalls.structural
+struct ResourceStats {
+    uint64_t mem_port = 0;    // fetch lost the unified memory port to a LOAD/STORE
+    uint64_t rf_read = 0;     // ID reading its operands over more cycles than one
+    uint64_t rf_write = 0;    // ID held: no write port free for its results at WB
+    uint64_t divider = 0;     // ID held: EX busy with a division
+    uint64_t divides = 0;     // DIVs executed
+};
+
+// Forwarding network (--bypass): which paths earn their wiring
+struct BypassStats {
+    std::array<uint64_t, kNumBypassPaths> used{};      // operands delivered over each path
+    std::array<uint64_t, kNumBypassPaths> missing{};   // RAW stall cycles that path alone would have saved
+};
+
+// Front end: where fetched instructions came from (--uop-cache, --lsd)
+struct FrontendStats {
+    uint64_t fetches = 0;          // instructions delivered to IF
+    uint64_t decodes = 0;          // ... read from the instruction source and decoded
+    uint64_t uop_hits = 0;
+    uint64_t uop_misses = 0;
+    uint64_t uop_evictions = 0;
+    uint64_t lsd_hits = 0;         // streamed from the loop buffer
+    uint64_t lsd_locks = 0;
+    uint64_t short_redirects = 0;  // mispredict targets that hit: one refill bubble saved
+
+    // Power proxies. Relative energy per delivered instruction: fetch+decode 1,
+    // micro-op cache read 0.4 (plus 0.1 per fill), loop buffer read 0.1.
+    double energy_units() const {
+        return (double)decodes + 0.4 * (double)uop_hits + 0.1 * (double)(uop_misses + lsd_hits);
+    }
+    double energy_pct() const { return fetches ? 100.0 * energy_units() / (double)fetches : 0.0; }
+    double hit_rate_pct() const {
+        return fetches ? 100.0 * (double)(uop_hits + lsd_hits) / (double)fetches : 0.0;
+    }
+};
+
+// Address translation (--itlb, --dtlb, --l2tlb, --pwc)
+struct TlbStats {
+    uint64_t itlb_accesses = 0;
+    uint64_t itlb_misses = 0;
+    uint64_t dtlb_accesses = 0;
+    uint64_t dtlb_misses = 0;
+    uint64_t l2_accesses = 0;     // L1 misses looked up in the L2 TLB
+    uint64_t l2_misses = 0;
+    uint64_t walks = 0;           // page-table walks
+    uint64_t walk_refs = 0;       // page-table memory references they made
+    uint64_t pwc_hits = 0;        // walks shortened by the page-walk cache
+    uint64_t cycles = 0;          // translation cycles on the correct path (L2 lookups + walks)
+};
+
+// Branches compared in ID (--branch-resolve id)
+struct BranchResolveStats {
+    uint64_t id_resolved = 0;       // branches resolved in ID
+    uint64_t operand_stalls = 0;    // RAW stall cycles only the ID comparator needs (also in stalls.raw)
+    double ex_baseline_cpi = 0.0;   // same run resolving in EX, filled in by the driver (0: not run)
+};
+
+// Events only the energy model needs (see energy_event_count)
+struct ActivityStats {
+    uint64_t rf_reads = 0;    // register file reads of retired instructions
+    uint64_t rf_writes = 0;   // ... and their writes (r0 excluded)
+    uint64_t flushes = 0;     // mispredict recoveries (direction, target or return)
+};
+
+// On-chip network (--noc): this core's line fetches, and the whole network
+struct NocStats {
+    uint64_t requests = 0;        // D-cache line fetches this core waited for
+    uint64_t request_cycles = 0;  // ... their round trips (request, slice access, response)
+    uint64_t packets = 0;         // packets delivered, all cores and both directions
+    uint64_t packet_cycles = 0;   // ... injection to arrival
+    uint64_t queue_cycles = 0;    // ... of which waiting for busy links
+    uint64_t hops = 0;
+
+    double avg_request_cycles() const { return requests ? (double)request_cycles / (double)requests : 0.0; }
+    double avg_packet_cycles() const { return packets ? (double)packet_cycles / (double)packets : 0.0; }
+    double avg_queue_cycles() const { return packets ? (double)queue_cycles / (double)packets : 0.0; }
+    double avg_hops() const { return packets ? (double)hops / (double)packets : 0.0; }
 };
 
 struct Metrics {
@@ -15,12 +288,134 @@ struct Metrics {
 
     // Branch prediction
     uint64_t bp_predictions = 0;
-    uint64_t bp_mispredictions = 0;
+    uint64_t bp_mispredictions = 0;      // direction only
+
+    // Indirect target prediction (JALRs other than returns, see --indirect)
+    uint64_t target_predictions = 0;
+    uint64_t target_mispredictions = 0;
 
     StallBreakdown stalls;
+    CpiStack cpi_stack;          // sums to cycles
+    LatencyStats latency;
+    MemoryStats mem;
+    CallStats calls;
+    FusionStats fusion;
+    BypassStats bypass;
+    ResourceStats resources;
+    FrontendStats frontend;
+    WrongPathStats wrong_path;
+    TlbStats tlb;
+    NocStats noc;
+    ActivityStats activity;
+    BranchResolveStats branch_resolve;
+    ConvergenceStats convergence;   // filled in by the driver when --converge is used
 
     double cpi() const { return retired ? double(cycles) / double(retired) : 0.0; }
+
+    // Add everything counted between two snapshots `from` and `to` of another run
+    void add_delta(const Metrics& to, const Metrics& from) {
+        cycles            += to.cycles - from.cycles;
+        retired           += to.retired - from.retired;
+        bp_predictions    += to.bp_predictions - from.bp_predictions;
+        bp_mispredictions += to.bp_mispredictions - from.bp_mispredictions;
+        target_predictions    += to.target_predictions - from.target_predictions;
+        target_mispredictions += to.target_mispredictions - from.target_mispredictions;
+        stalls.raw        += to.stalls.raw - from.stalls.raw;
+        stalls.war        += to.stalls.war - from.stalls.war;
+        stalls.waw        += to.stalls.waw - from.stalls.waw;
+        stalls.control    += to.stalls.control - from.stalls.control;
+        stalls.sb_full    += to.stalls.sb_full - from.stalls.sb_full;
+        stalls.stlf_partial += to.stalls.stlf_partial - from.stalls.stlf_partial;
+        stalls.dcache_miss  += to.stalls.dcache_miss - from.stalls.dcache_miss;
+        stalls.itlb_miss    += to.stalls.itlb_miss - from.stalls.itlb_miss;
+        stalls.dtlb_miss    += to.stalls.dtlb_miss - from.stalls.dtlb_miss;
+        stalls.structural   += to.stalls.structural - from.stalls.structural;
+        resources.mem_port  += to.resources.mem_port - from.resources.mem_port;
+        resources.rf_read   += to.resources.rf_read - from.resources.rf_read;
+        resources.rf_write  += to.resources.rf_write - from.resources.rf_write;
+        resources.divider   += to.resources.divider - from.resources.divider;
+        resources.divides   += to.resources.divides - from.resources.divides;
+        mem.loads         += to.mem.loads - from.mem.loads;
+        mem.stores        += to.mem.stores - from.mem.stores;
+        mem.stlf_forwards += to.mem.stlf_forwards - from.mem.stlf_forwards;
+        mem.early_loads   += to.mem.early_loads - from.mem.early_loads;
+        mem.held_loads    += to.mem.held_loads - from.mem.held_loads;
+        mem.false_dependences += to.mem.false_dependences - from.mem.false_dependences;
+        mem.order_violations  += to.mem.order_violations - from.mem.order_violations;
+        mem.replay_bubbles    += to.mem.replay_bubbles - from.mem.replay_bubbles;
+        mem.dcache_accesses   += to.mem.dcache_accesses - from.mem.dcache_accesses;
+        mem.dcache_misses     += to.mem.dcache_misses - from.mem.dcache_misses;
+        wrong_path.instructions     += to.wrong_path.instructions - from.wrong_path.instructions;
+        wrong_path.loads            += to.wrong_path.loads - from.wrong_path.loads;
+        wrong_path.fills            += to.wrong_path.fills - from.wrong_path.fills;
+        wrong_path.prefetch_hits    += to.wrong_path.prefetch_hits - from.wrong_path.prefetch_hits;
+        wrong_path.pollution_misses += to.wrong_path.pollution_misses - from.wrong_path.pollution_misses;
+        calls.calls              += to.calls.calls - from.calls.calls;
+        calls.returns            += to.calls.returns - from.calls.returns;
+        calls.ras_overflows      += to.calls.ras_overflows - from.calls.ras_overflows;
+        calls.ras_underflows     += to.calls.ras_underflows - from.calls.ras_underflows;
+        calls.return_mispredicts += to.calls.return_mispredicts - from.calls.return_mispredicts;
+        fusion.pairs             += to.fusion.pairs - from.fusion.pairs;
+        for (int r = 0; r < kNumFusionRules; ++r)
+            fusion.by_rule[r] += to.fusion.by_rule[r] - from.fusion.by_rule[r];
+        for (int p = 0; p < kNumBypassPaths; ++p) {
+            bypass.used[p]    += to.bypass.used[p] - from.bypass.used[p];
+            bypass.missing[p] += to.bypass.missing[p] - from.bypass.missing[p];
+        }
+        tlb.itlb_accesses += to.tlb.itlb_accesses - from.tlb.itlb_accesses;
+        tlb.itlb_misses   += to.tlb.itlb_misses - from.tlb.itlb_misses;
+        tlb.dtlb_accesses += to.tlb.dtlb_accesses - from.tlb.dtlb_accesses;
+        tlb.dtlb_misses   += to.tlb.dtlb_misses - from.tlb.dtlb_misses;
+        tlb.l2_accesses   += to.tlb.l2_accesses - from.tlb.l2_accesses;
+        tlb.l2_misses     += to.tlb.l2_misses - from.tlb.l2_misses;
+        tlb.walks         += to.tlb.walks - from.tlb.walks;
+        tlb.walk_refs     += to.tlb.walk_refs - from.tlb.walk_refs;
+        tlb.pwc_hits      += to.tlb.pwc_hits - from.tlb.pwc_hits;
+        tlb.cycles        += to.tlb.cycles - from.tlb.cycles;
+        branch_resolve.id_resolved    += to.branch_resolve.id_resolved - from.branch_resolve.id_resolved;
+        branch_resolve.operand_stalls += to.branch_resolve.operand_stalls - from.branch_resolve.operand_stalls;
+        activity.rf_reads  += to.activity.rf_reads - from.activity.rf_reads;
+        activity.rf_writes += to.activity.rf_writes - from.activity.rf_writes;
+        activity.flushes   += to.activity.flushes - from.activity.flushes;
+        noc.requests       += to.noc.requests - from.noc.requests;
+        noc.request_cycles += to.noc.request_cycles - from.noc.request_cycles;
+        noc.packets        += to.noc.packets - from.noc.packets;
+        noc.packet_cycles  += to.noc.packet_cycles - from.noc.packet_cycles;
+        noc.queue_cycles   += to.noc.queue_cycles - from.noc.queue_cycles;
+        noc.hops           += to.noc.hops - from.noc.hops;
+        frontend.fetches         += to.frontend.fetches - from.frontend.fetches;
+        frontend.decodes         += to.frontend.decodes - from.frontend.decodes;
+        frontend.uop_hits        += to.frontend.uop_hits - from.frontend.uop_hits;
+        frontend.uop_misses      += to.frontend.uop_misses - from.frontend.uop_misses;
+        frontend.uop_evictions   += to.frontend.uop_evictions - from.frontend.uop_evictions;
+        frontend.lsd_hits        += to.frontend.lsd_hits - from.frontend.lsd_hits;
+        frontend.lsd_locks       += to.frontend.lsd_locks - from.frontend.lsd_locks;
+        frontend.short_redirects += to.frontend.short_redirects - from.frontend.short_redirects;
+        for (int c = 0; c < kNumCpiComponents; ++c)
+            cpi_stack.cycles[c] += to.cpi_stack.cycles[c] - from.cpi_stack.cycles[c];
+        for (int c = 0; c < kNumOpClasses; ++c) {
+            latency.total[c].add_delta(to.latency.total[c], from.latency.total[c]);
+            for (int s = 0; s < kNumTrackedStages; ++s)
+                latency.stage[c][s].add_delta(to.latency.stage[c][s], from.latency.stage[c][s]);
+        }
+    }
     double bp_accuracy_pct() const {
         return bp_predictions ? 100.0 * (double(bp_predictions - bp_mispredictions) / double(bp_predictions)) : 0.0;
     }
+    // Share of retired instructions that travelled in a fused slot
+    double fusion_rate_pct() const {
+        return retired ? 100.0 * double(2 * fusion.pairs) / double(retired) : 0.0;
+    }
+    // Misses per thousand retired instructions
+    double mpki(uint64_t misses) const { return retired ? 1000.0 * double(misses) / double(retired) : 0.0; }
+    double itlb_mpki() const { return mpki(tlb.itlb_misses); }
+    double dtlb_mpki() const { return mpki(tlb.dtlb_misses); }
+    double l2tlb_mpki() const { return mpki(tlb.l2_misses); }
+    // Share of cycles the decoders were busy
+    double decode_duty_pct() const {
+        return cycles ? 100.0 * double(frontend.decodes) / double(cycles) : 0.0;
+    }
+    double target_accuracy_pct() const {
+        return target_predictions ? 100.0 * (double(target_predictions - target_mispredictions) / double(target_predictions)) : 0.0;
+    }
 };
@@ -0,0 +1,149 @@
+#pragma once
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// On-chip network between cores and shared L2 slices (--noc)
+enum class NocTopology : uint8_t {
+    None,   // D-cache misses cost a flat latency
+    Mesh,   // 2-D mesh, XY dimension-order routing
+    Ring,   // bidirectional ring, shortest direction
+};
+
+inline const char* noc_topology_name(NocTopology t) {
+    switch (t) {
+        case NocTopology::None: return "none";
+        case NocTopology::Mesh: return "mesh";
+        case NocTopology::Ring: return "ring";
+    }
+    return "?";
+}
+
+inline bool parse_noc_topology(const std::string& s, NocTopology& out) {
+    for (NocTopology t : {NocTopology::None, NocTopology::Mesh, NocTopology::Ring})
+        if (s == noc_topology_name(t)) { out = t; return true; }
+    return false;
+}
+
+// Event-driven interconnect model. Every tile holds a core and an L2 slice;
+// the simulated core is tile 0 and lines are interleaved across the slices.
+// The other cores are not simulated: each injects line requests to random
+// slices at `load_per_kcycle` per 1000 cycles (geometric inter-arrival times),
+// so the network sees 16-64-core traffic levels without 16-64 pipelines.
+//
+// A packet advances one hop per event. A hop costs `hop_cycles` (router and
+// wire) plus serialization on a link moving `link_flits` flits per cycle; a
+// link busy with an earlier packet queues the next one (FCFS). Requests are
+// one flit, data responses one header flit plus the line. Only packets in
+// flight generate events, so idle links cost nothing to simulate.
+class Noc {
+public:
+    static constexpr int kMaxCores = 64;
+    static constexpr int kFlitBytes = 16;
+
+    Noc() = default;
+    Noc(NocTopology topo, int cores, int hop_cycles, int link_flits, int load_per_kcycle,
+        int slice_cycles, int line_bytes);
+
+    bool enabled() const { return topo_ != NocTopology::None; }
+    int cores() const { return cores_; }
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+
+    // Line fetch by the simulated core at cycle `now`: request to the home
+    // slice, slice access, data response. Returns the cycles until the data is
+    // back. With wait = false (a store's write-allocate fill) the packets are
+    // injected but not waited for, and 0 is returned.
+    int fetch_line(int64_t line, uint64_t now, bool wait = true);
+
+    // Run every event up to and including cycle `t`
+    void advance(uint64_t t);
+    uint64_t now() const { return now_; }
+
+    struct Stats {
+        uint64_t packets = 0;             // all packets delivered (both directions, all cores)
+        uint64_t packet_cycles = 0;       // ... their injection-to-arrival latency
+        uint64_t queue_cycles = 0;        // ... of which spent waiting for busy links
+        uint64_t hops = 0;
+    };
+    const Stats& stats() const { return stats_; }
+
+    struct Link {
+        int16_t from = 0, to = 0;         // tiles
+        uint64_t free_at = 0;             // first cycle the link can start a new packet
+        uint64_t busy = 0;                // cycles spent moving flits
+        uint64_t packets = 0;
+        uint64_t queue = 0;               // cycles packets waited for it
+        // Busy cycles up to cycle `t` (busy counts reservations, which may run past it)
+        uint64_t busy_by(uint64_t t) const {
+            const uint64_t ahead = free_at > t ? free_at - t : 0;
+            return busy > ahead ? busy - ahead : 0;
+        }
+    };
+    const std::vector<Link>& links() const { return links_; }
+
+    // Everything that decides future behaviour (for state hashing), ages relative to `now`
+    template <typename F>
+    void for_each(uint64_t now, F&& f) const {
+        f(rng_);
+        for (const Link& l : links_) f(l.free_at > now ? l.free_at - now : 0);
+        for (const Event& e : events_)
+            f(((e.time - now) << 24) ^ ((uint64_t)e.what << 8) ^ (uint64_t)e.kind);
+        for (const Packet& p : packets_)
+            if (p.live)
+                f(((uint64_t)(uint16_t)p.at << 48) | ((uint64_t)(uint16_t)p.src << 32) |
+                  ((uint64_t)(uint16_t)p.dst << 16) | ((uint64_t)p.response << 1) | (uint64_t)p.tracked);
+    }
+
+    void save(std::ostream& os) const;
+    bool load(std::istream& is);
+
+private:
+    enum class EventKind : uint8_t { Hop, Inject };
+    struct Event {
+        uint64_t time;
+        uint64_t seq;        // tie-break: same-cycle events run in creation order
+        uint32_t what;       // Hop: packet index; Inject: injecting core
+        EventKind kind;
+    };
+    struct Packet {
+        int16_t src = 0, dst = 0, at = 0;
+        uint16_t flits = 1;
+        uint64_t injected = 0;
+        uint64_t queued = 0;         // cycles spent waiting for busy links so far
+        bool response = false;
+        bool tracked = false;        // the simulated core is waiting for this one's response
+        bool live = false;
+    };
+
+    int next_tile(int at, int dst) const;
+    int link_index(int from, int to) const;
+    void schedule(uint64_t time, uint32_t what, EventKind kind);
+    uint32_t new_packet(int src, int dst, bool response, bool tracked, uint64_t now);
+    void run_one();
+    void deliver(Packet& p, uint32_t idx, uint64_t t);
+    uint64_t next_gap();
+    uint64_t rand64();
+
+    NocTopology topo_ = NocTopology::None;
+    int cores_ = 0, rows_ = 0, cols_ = 0;
+    int hop_cycles_ = 1;
+    int link_flits_ = 1;
+    int load_ = 0;                   // requests per core per 1000 cycles
+    int slice_cycles_ = 0;
+    int line_flits_ = 1;
+
+    std::vector<Link> links_;
+    std::vector<int> link_of_;       // from * cores + to -> link index (-1: not adjacent)
+    std::vector<Event> events_;      // min-heap on (time, seq)
+    std::vector<Packet> packets_;
+    std::vector<uint32_t> free_packets_;
+    uint64_t seq_ = 0;
+    uint64_t now_ = 0;               // time of the last event run
+    uint64_t rng_ = 0x9e3779b97f4a7c15ull;
+    static constexpr uint64_t kPending = ~0ull;
+    uint64_t tracked_done_ = 0;      // arrival cycle of the last tracked response (kPending: in flight)
+    Stats stats_;
+};
@@ -1,53 +1,250 @@
 #pragma once
+#include <array>
 #include <vector>
 #include <string>
+#include <climits>
+#include <istream>
+#include <ostream>
 #include <unordered_map>
 #include "instr.hpp"
+#include "instr_source.hpp"
 #include "metrics.hpp"
 #include "hazard.hpp"
+#include "reservation_table.hpp"
 #include "predictor.hpp"
+#include "store_buffer.hpp"
+#include "store_sets.hpp"
+#include "ras.hpp"
+#include "ittage.hpp"
+#include "fusion.hpp"
+#include "uop_cache.hpp"
+#include "loop_stream.hpp"
+#include "data_cache.hpp"
+#include "tlb.hpp"
+#include "noc.hpp"
+#include "hash.hpp"
 
 // Pipeline register structs (classic 5-stage: IF, ID, EX, MEM, WB)
-struct IFID  { Instruction ins; bool valid = false; };
-struct IDEX  { Instruction ins; bool valid = false; };   // ID stage register feeding EX
-struct EXMEM { Instruction ins; bool valid = false; };   // EX stage register feeding MEM
-struct MEMWB { Instruction ins; bool valid = false; };   // MEM stage register feeding WB
+// `cause` says why an invalid slot is empty; it travels with the bubble so the
+// cycle it reaches WB can be charged to the right CPI-stack component.
+struct IFID  { Instruction ins; bool valid = false; CpiComponent cause = CpiComponent::Fetch; };
+struct IDEX  { Instruction ins; bool valid = false; CpiComponent cause = CpiComponent::Fetch; };   // ID stage register feeding EX
+struct EXMEM { Instruction ins; bool valid = false; CpiComponent cause = CpiComponent::Fetch; };   // EX stage register feeding MEM
+struct MEMWB { Instruction ins; bool valid = false; CpiComponent cause = CpiComponent::Fetch; };   // MEM stage register feeding WB
+
+// Structured form of one timeline row (what csv_row() prints), for binary consumers
+struct TimelineCell {
+    enum Kind : uint8_t { Empty = 0, Instr = 1, Stall = 2 };
+    uint8_t kind = Empty;
+    uint8_t code = 0;     // Instr: Opcode; Stall: CpiComponent of the bubble
+    int32_t id   = -1;
+};
+struct TimelineRow {
+    uint64_t cycle = 0;
+    TimelineCell cell[5];   // IF, ID, EX, MEM, WB
+};
+
+// Loads reading memory in EX, one stage early (hides the load-use bubble)
+enum class EarlyLoads : uint8_t {
+    Off,        // loads access memory in MEM
+    Naive,      // every load goes early; conflicts with the store in MEM are replayed
+    StoreSets,  // loads predicted dependent on an in-flight store wait (see StoreSets)
+};
+const char* early_loads_name(EarlyLoads e);
+bool parse_early_loads(const std::string& s, EarlyLoads& out);
+
+// Where BEQ/BNE are compared against their prediction
+enum class BranchResolve : uint8_t {
+    Ex,   // ALU in EX: a mispredict costs the squash plus control_flush_bubbles_
+    Id,   // dedicated comparator in ID: one bubble, but operands must be ready a stage earlier
+};
+const char* branch_resolve_name(BranchResolve b);
+bool parse_branch_resolve(const std::string& s, BranchResolve& out);
+
+// Microarchitectural knobs (add new ones to hash() so cached runs notice them)
+struct PipelineConfig {
+    bool forwarding = true;
+    uint8_t bypass_paths = kDefaultBypassPaths;   // BypassPath bitmask, used while forwarding is on
+    int  store_buffer = 4;        // entries; 0 = stores complete in MEM with no buffer
+    int  sb_drain_cycles = 1;     // cycles to write one buffered store to the cache
+    EarlyLoads early_loads = EarlyLoads::Off;
+    BranchResolve branch_resolve = BranchResolve::Ex;
+    int  ras_depth = 16;          // return address stack entries; 0 = no RAS
+    IndirectMode indirect = IndirectMode::Ittage;
+    uint8_t fusion_rules = 0;     // FusionRule bitmask; 0 = no fusion
+    int  uop_cache = 0;           // decoded-instruction cache entries; 0 = none
+    int  uop_ways = 8;
+    UopReplacement uop_repl = UopReplacement::Lru;
+    int  lsd_entries = 0;         // loop stream detector buffer; 0 = none
+    int  dcache_lines = 0;        // L1 data cache lines; 0 = every access hits
+    int  dcache_ways = 2;
+    int  dcache_miss_cycles = 8;  // extra cycles a missing LOAD holds MEM
+    bool wrong_path = false;      // keep fetching/executing down the predicted path after a mispredict
+    // Address translation; an L1 TLB with 0 entries means that side is not translated
+    int  itlb_entries = 0, itlb_ways = 4;
+    int  dtlb_entries = 0, dtlb_ways = 4;
+    int  l2tlb_entries = 0, l2tlb_ways = 8;   // shared; 0 = L1 misses go straight to a walk
+    int  l2tlb_cycles = 4;        // L2 TLB lookup after an L1 miss
+    int  page_bytes = 4096;       // power of two
+    int  walk_levels = 4;
+    int  walk_level_cycles = 8;   // per page-table reference
+    int  pwc_entries = 0;         // page-walk cache; 0 = none
+    // On-chip network to shared L2 slices; D-cache misses cross it instead of
+    // costing a flat dcache_miss_cycles (which becomes the slice access time)
+    NocTopology noc = NocTopology::None;
+    int  noc_cores = 16;          // tiles (core + L2 slice each)
+    int  noc_hop_cycles = 2;      // router + wire per hop
+    int  noc_link_flits = 1;      // link bandwidth, flits per cycle
+    int  noc_load = 0;            // other cores' line requests per 1000 cycles each
+    // Structural resources, booked in a ReservationTable
+    bool unified_memory = false;  // one memory port for IF and the data side (a LOAD/STORE wins)
+    int  rf_read_ports = 0;       // register file ports; 0 = as many as needed
+    int  rf_write_ports = 0;
+    int  div_cycles = 8;          // the one, non-pipelined divider: EX cycles per DIV
+
+    uint64_t hash() const {
+        uint64_t h = kHashSeed;
+        h = hash_mix(h, forwarding);
+        h = hash_mix(h, (uint64_t)bypass_paths);
+        h = hash_mix(h, (uint64_t)store_buffer);
+        h = hash_mix(h, (uint64_t)sb_drain_cycles);
+        h = hash_mix(h, (uint64_t)early_loads);
+        h = hash_mix(h, (uint64_t)branch_resolve);
+        h = hash_mix(h, (uint64_t)ras_depth);
+        h = hash_mix(h, (uint64_t)indirect);
+        h = hash_mix(h, (uint64_t)fusion_rules);
+        h = hash_mix(h, (uint64_t)uop_cache);
+        h = hash_mix(h, (uint64_t)uop_ways);
+        h = hash_mix(h, (uint64_t)uop_repl);
+        h = hash_mix(h, (uint64_t)lsd_entries);
+        h = hash_mix(h, (uint64_t)dcache_lines);
+        h = hash_mix(h, (uint64_t)dcache_ways);
+        h = hash_mix(h, (uint64_t)dcache_miss_cycles);
+        h = hash_mix(h, wrong_path);
+        for (int v : {itlb_entries, itlb_ways, dtlb_entries, dtlb_ways, l2tlb_entries, l2tlb_ways,
+                      l2tlb_cycles, page_bytes, walk_levels, walk_level_cycles, pwc_entries})
+            h = hash_mix(h, (uint64_t)v);
+        h = hash_mix(h, (uint64_t)noc);
+        for (int v : {noc_cores, noc_hop_cycles, noc_link_flits, noc_load}) h = hash_mix(h, (uint64_t)v);
+        h = hash_mix(h, unified_memory);
+        for (int v : {rf_read_ports, rf_write_ports, div_cycles}) h = hash_mix(h, (uint64_t)v);
+        return h;
+    }
+};
 
 class Pipeline {
 public:
-    Pipeline(const std::vector<Instruction>& program,
-             bool forwarding_on = true,
+    Pipeline(const InstructionSource& program,
+             const PipelineConfig& cfg,
              BranchPredictor* bp = nullptr);
+    Pipeline(const InstructionSource& program,
+             bool forwarding_on = true,
+             BranchPredictor* bp = nullptr)
+    : Pipeline(program, PipelineConfig{forwarding_on}, bp) {}
 
     // Advance one cycle
     void step();
 
     // State
     bool halted() const { return halted_; }
-    int  cycle()  const { return cycle_; }
+    uint64_t cycle() const { return cycle_; }
 
     // CSV of pipeline stages (6 columns): cycle,IF,ID,EX,MEM,WB
     std::string csv_row() const;
+    // Same row in structured form
+    void timeline_row(TimelineRow& row) const;
 
     // Metrics
     const Metrics& metrics() const { return m_; }
+    // Interconnect, for per-link utilization
+    const Noc& noc() const { return noc_; }
+
+    // --- checkpointing ---
+    // Hash of everything that decides future behaviour (registers, fetch PC,
+    // pending redirects, predictor tables); independent of the absolute cycle
+    // and of the metrics, so two runs can be compared for reconvergence.
+    uint64_t state_hash() const;
+    // Pipeline state incl. metrics (not the predictor, which is not owned). Disabled
+    // components are skipped; without `indirect_tables` the indirect predictor is too,
+    // for callers that keep it as PredictorState entries instead (see TimeTravel).
+    void save_state(std::ostream& os, bool indirect_tables = true) const;
+    bool load_state(std::istream& is, bool indirect_tables = true);
+    void save_indirect_tables(PredictorState& out, uint32_t first) const { ind_.save_tables(out, first); }
+    void load_indirect_tables(const PredictorState& in, uint32_t first) { ind_.load_tables(in, first); }
+    // Lowest / highest PC fetch was attempted at since the last call ([INT_MAX, -1] if none)
+    void take_fetch_range(int& lo, int& hi) {
+        lo = fetch_lo_; hi = fetch_hi_;
+        fetch_lo_ = INT_MAX; fetch_hi_ = -1;
+    }
 
 private:
     // Helpers
     static inline bool is_branch(const Instruction& ins) {
-        return ins.op == Opcode::BEQ || ins.op == Opcode::BNE;
+        const Opcode op = ins.fused ? ins.fused_op : ins.op;
+        return op == Opcode::BEQ || op == Opcode::BNE;
+    }
+    // PC of the control part of a slot (the second half of a fused compare-and-branch)
+    static inline int ctl_pc(const Instruction& ins) {
+        return ins.pc + (ins.fused ? 1 : 0);
+    }
+    // Compared in ID (--branch-resolve id); a fused compare-and-branch still needs the ALU
+    bool resolves_in_id(const Instruction& ins) const {
+        return cfg_.branch_resolve == BranchResolve::Id && bp_ && is_branch(ins) && !ins.fused;
     }
     // Toy ground-truth: branch taken iff imm < 0 (consistent with prior samples)
     static inline bool actual_taken_of(const Instruction& ins) {
         return ins.imm < 0;
     }
+    // Jump target at EX. Registers carry no values, except that JAL/JALR leave
+    // the return PC in their rd; JALR through any other register jumps to imm.
+    int jump_target(const Instruction& ins) const {
+        return ins.op == Opcode::JAL ? ins.pc + 1 + ins.imm : link_[ins.rs1] + ins.imm;
+    }
+    // Predicts a branch/jump in ID (recording the prediction); returns the next fetch PC
+    int predict_at_id(const Instruction& ins, uint64_t now);
+    // Decoded instruction at `pc`: from the loop buffer, the micro-op cache or,
+    // failing both, the instruction source (filling the micro-op cache)
+    Instruction fetch_decoded(int pc);
+    // IF for this cycle from `fetch_pc`: through the iTLB and the fetch port to
+    // fetch_decoded(); returns the new IF/ID and moves pc_ past what it fetched
+    IFID fetch_stage(int fetch_pc, uint64_t now);
+    // Compares a just-predicted branch in ID and trains the predictors; returns
+    // the correct next PC (the caller squashes the fetch if it differs)
+    int resolve_at_id(const Instruction& br, uint64_t now);
+    // Correct-path D-cache access by the LOAD/STORE in MEM (or an early LOAD in
+    // EX); returns true while a LOAD miss has to hold MEM
+    bool dcache_access(int64_t addr, bool is_load);
+    // Wrong-path instruction: counted, sent to the D-cache if it is a load;
+    // returns where the predicted path goes next (-1: can't tell)
+    int execute_wrong_path(const Instruction& ins);
+    // Translates `vaddr` through the L1 iTLB/dTLB, the L2 TLB and, on a miss
+    // there, a page walk; returns the extra cycles (0 on an L1 hit). Wrong-path
+    // translations fill the TLBs without being charged or counted in tlb.cycles.
+    int translate(int64_t vaddr, bool data, bool wrong_path = false);
+    // Runs the interconnect up to `now` and mirrors its counters into metrics().noc
+    void noc_advance(uint64_t now);
+    // Structural hazards of the slot leaving ID in `now`: false (counted per
+    // resource) if it has to wait, else its divider and write-port needs are booked
+    bool book_resources(const Instruction& ins, uint64_t now);
+    // The memory port is free for a fetch of `pc` (uop cache / loop buffer hits don't need it)
+    bool fetch_port_free(int pc, uint64_t now) const {
+        return !cfg_.unified_memory || lsd_.covers(pc) || uop_.contains(pc) ||
+               rt_.free(now, ReservationTable::kMemPort);
+    }
+    uint64_t vpn_of(int64_t vaddr) const {   // floor division, like DataCache lines
+        const int64_t pb = cfg_.page_bytes;
+        return (uint64_t)(vaddr >= 0 ? vaddr / pb : -((-vaddr + pb - 1) / pb));
+    }
+
+    // Record fetch-to-retire latency and per-stage residency of a retiring instruction
+    void record_latency(const Instruction& ins, uint64_t retire_cycle);
 
 private:
-    const std::vector<Instruction>& prog_;
+    const InstructionSource* prog_;   // not owned
     int  pc_       = 0;     // next fetch PC
-    int  cycle_    = 0;
+    uint64_t cycle_ = 0;
     bool halted_   = false;
-    bool forwarding_ = true;
+    PipelineConfig cfg_;
 
     // Optional predictor (not owned)
     BranchPredictor* bp_ = nullptr;
@@ -65,13 +262,57 @@ private:
     // Control mispredict flush countdown (2 bubbles for EX-resolution)
     int control_flush_bubbles_ = 0;
 
-    // Bookkeep predicted direction per-instruction (prediction made in ID)
-    std::unordered_map<int, bool> pred_taken_by_id_;
+    // Bookkeep prediction per-instruction (made in ID, checked in EX)
+    struct Prediction {
+        bool taken = false;
+        int  next_pc = -1;
+        ReturnAddressStack::Checkpoint ras;   // RAS right after this instruction's push/pop
+    };
+    std::unordered_map<int, Prediction> pred_by_id_;
+    ReturnAddressStack ras_;
+    IttagePredictor ind_;
+    std::array<int32_t, kNumRegs> link_{};    // return PC held by each register (see jump_target)
 
     // Label for the bubble we explicitly inserted this cycle into the ID→EX slot.
     // Example values: "", "STALL_RAW", "STALL_CTRL", (future: "STALL_WAR", "STALL_WAW")
     std::string ex_bubble_label_;
 
+    // Committed stores on their way to the cache; searched by loads in MEM
+    StoreBuffer sb_;
+    // Label for a bubble MEM sent to WB this cycle ("STALL_SB", "STALL_STLF")
+    std::string mem_bubble_label_;
+    // Memory dependence prediction for early loads
+    StoreSets ss_;
+    bool early_in_mem_ = false;   // the LOAD in MEM already read memory in EX
+
+    // Front end: decoded-instruction cache and loop stream detector
+    UopCache uop_;
+    LoopStreamDetector lsd_;
+
+    // L1 data cache; the LOAD in MEM may be waiting on a miss
+    DataCache dc_;
+    bool dc_pending_ = false;     // the LOAD in MEM has accessed the cache
+    int  dc_wait_ = 0;            // miss cycles it still has to wait
+    // TLBs; the instruction being fetched or the one in MEM may be waiting on a translation
+    Tlb itlb_, dtlb_, l2tlb_, pwc_;
+    int      ixlate_pc_ = -1;     // fetch PC translated (-1: none)
+    int      ixlate_wait_ = 0;
+    uint64_t dxlate_inum_ = 0;    // t_fetch + 1 of the MEM instruction translated (0: none)
+    int      dxlate_wait_ = 0;
+    // Interconnect D-cache misses travel over (--noc)
+    Noc noc_;
+    // Next wrong-path fetch PC while a mispredict's refill is in progress (-1: none)
+    int wp_pc_ = -1;
+    // Structural resources booked per cycle; the DIV in EX/MEM may still be dividing
+    ReservationTable rt_;
+    int      div_left_ = 0;       // EX cycles the DIV in exmem_ still needs after this one
+    uint64_t id_read_inum_ = 0;   // t_fetch + 1 of the slot reading operands in ID (0: none)
+    int      id_reads_left_ = 0;  // ... and the register reads it still has to make
+
+    // Fetch PCs attempted since take_fetch_range() (past-the-end ones included)
+    int fetch_lo_ = INT_MAX;
+    int fetch_hi_ = -1;
+
     // Metrics
     Metrics m_;
 };
@@ -1,6 +1,24 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Flat (key, value) view of a predictor's tables, used by snapshots.
+// Keys are (table << 32) | (uint32_t)pc; order is unspecified until sorted.
+using PredictorState = std::vector<std::pair<uint64_t, int64_t>>;
+
+template <typename T>
+inline void save_table(PredictorState& out, uint32_t table, const std::unordered_map<int, T>& m) {
+    for (const auto& [pc, v] : m) out.emplace_back(((uint64_t)table << 32) | (uint32_t)pc, (int64_t)v);
+}
+template <typename T>
+inline void load_table(const PredictorState& in, uint32_t table, std::unordered_map<int, T>& m) {
+    m.clear();
+    for (const auto& [k, v] : in)
+        if ((uint32_t)(k >> 32) == table) m[(int)(uint32_t)k] = (T)v;
+}
 
 // Branch predictor base class
 class BranchPredictor {
@@ -10,12 +28,19 @@ public:
     // Predict whether branch at PC is taken
     virtual bool predict(int pc) = 0;
 
+    // Same prediction without counting it or touching any table (wrong-path fetch)
+    virtual bool peek(int pc) const = 0;
+
     // Update predictor state with actual outcome
     virtual void update(int pc, bool taken) = 0;
 
     // Human-readable name
     virtual std::string name() const = 0;
 
+    // Table contents (not the stats below) for snapshot / restore
+    virtual void save_state(PredictorState&) const {}
+    virtual void load_state(const PredictorState&) {}
+
     // Stats
     int total_predictions = 0;
     int mispredictions    = 0;
@@ -33,7 +58,8 @@ public:
 class StaticPredictor : public BranchPredictor {
 public:
     explicit StaticPredictor(bool taken) : always_taken_(taken) {}
-    bool predict(int) override { total_predictions++; return always_taken_; }
+    bool predict(int pc) override { total_predictions++; return peek(pc); }
+    bool peek(int) const override { return always_taken_; }
     void update(int, bool actual) override {
         if (always_taken_ != actual) mispredictions++;
     }
@@ -49,6 +75,9 @@ class OneBitPredictor : public BranchPredictor {
 public:
     bool predict(int pc) override {
         total_predictions++;
+        return peek(pc);
+    }
+    bool peek(int pc) const override {
         auto it = table.find(pc);
         if (it == table.end()) return false; // default not taken
         return it->second;
@@ -59,6 +88,8 @@ public:
         table[pc] = actual;
     }
     std::string name() const override { return "OneBit"; }
+    void save_state(PredictorState& out) const override { save_table(out, 0, table); }
+    void load_state(const PredictorState& in) override { load_table(in, 0, table); }
 private:
     std::unordered_map<int, bool> table; // pc -> last outcome
 };
@@ -71,6 +102,10 @@ public:
         int state = table[pc];
         return state >= 2; // 2 or 3 = predict taken
     }
+    bool peek(int pc) const override {
+        auto it = table.find(pc);
+        return it != table.end() && it->second >= 2;
+    }
     void update(int pc, bool actual) override {
         bool pred = predict(pc);
         if (pred != actual) mispredictions++;
@@ -83,6 +118,8 @@ public:
         }
     }
     std::string name() const override { return "TwoBit"; }
+    void save_state(PredictorState& out) const override { save_table(out, 0, table); }
+    void load_state(const PredictorState& in) override { load_table(in, 0, table); }
 private:
     std::unordered_map<int, int> table; // pc -> state (0..3)
 };
@@ -108,6 +145,11 @@ public:
         total_predictions++;
         return chosen_pred;
     }
+    bool peek(int pc) const override {
+        auto it = chooser_.find(pc);
+        const bool use_two = it != chooser_.end() && it->second >= 2;
+        return use_two ? twobit_.peek(pc) : onebit_.peek(pc);
+    }
 
     void update(int pc, bool actual) override {
         // Was our chosen prediction correct?
@@ -132,6 +174,36 @@ public:
 
     std::string name() const override { return "Tournament(1b vs 2b)"; }
 
+    // Component tables go to separate key ranges (components first, then ours)
+    void save_state(PredictorState& out) const override {
+        PredictorState sub;
+        onebit_.save_state(sub);
+        for (auto& [k, v] : sub) out.emplace_back(k | (1ull << 32), v);
+        sub.clear();
+        twobit_.save_state(sub);
+        for (auto& [k, v] : sub) out.emplace_back(k | (2ull << 32), v);
+        save_table(out, 3, chooser_);
+        save_table(out, 4, last_p1_);
+        save_table(out, 5, last_p2_);
+        save_table(out, 6, used_two_);
+        save_table(out, 7, last_chosen_);
+    }
+    void load_state(const PredictorState& in) override {
+        PredictorState sub;
+        for (const auto& [k, v] : in)
+            if ((k >> 32) == 1) sub.emplace_back((uint32_t)k, v);
+        onebit_.load_state(sub);
+        sub.clear();
+        for (const auto& [k, v] : in)
+            if ((k >> 32) == 2) sub.emplace_back((uint32_t)k, v);
+        twobit_.load_state(sub);
+        load_table(in, 3, chooser_);
+        load_table(in, 4, last_p1_);
+        load_table(in, 5, last_p2_);
+        load_table(in, 6, used_two_);
+        load_table(in, 7, last_chosen_);
+    }
+
 private:
     OneBitPredictor onebit_;
     TwoBitPredictor twobit_;
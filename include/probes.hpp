@@ -0,0 +1,73 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include "instr.hpp"
+
+// Static tracing probes inside Pipeline::step().
+//
+// Built with -DCPU_SIM_PROBES=ON (CMake option) the probes record into a global
+// ring buffer that keeps the last CPU_SIM_PROBE_RING events, for crash dumps and
+// for looking at the tail of long runs. Without it SIM_PROBE expands to nothing:
+// the arguments are not even evaluated.
+
+enum class ProbeKind : uint8_t {
+    Fetch,          // instruction fetched into IF
+    StallDecision,  // hazard unit stalls ID (arg: 1 = load-use)
+    BubbleInsert,   // bubble injected into ID->EX (arg: CpiComponent of the bubble)
+    BranchPredict,  // direction predicted in ID (arg: predicted taken)
+    Resolve,        // branch resolved in EX (arg: actually taken)
+    Mispredict,     // prediction was wrong (arg: redirect PC)
+    Retire,         // instruction left WB
+    MemStall,       // MEM held its instruction (arg: CpiComponent of the bubble sent to WB)
+    Replay,         // early load squashed after a memory-order violation (arg: store PC)
+};
+
+const char* probe_kind_name(ProbeKind k);
+
+struct ProbeEvent {
+    uint64_t  cycle;
+    int32_t   id;
+    int32_t   pc;
+    int32_t   arg;
+    ProbeKind kind;
+};
+
+// Fixed-size ring of the most recent events (oldest overwritten)
+template <size_t N>
+class ProbeRing {
+public:
+    void push(const ProbeEvent& e) {
+        buf_[head_ % N] = e;
+        head_++;
+    }
+    size_t size() const { return head_ < N ? (size_t)head_ : N; }
+    uint64_t total() const { return head_; }
+    // i-th retained event, 0 = oldest
+    const ProbeEvent& at(size_t i) const { return buf_[(head_ - size() + i) % N]; }
+
+private:
+    ProbeEvent buf_[N] = {};
+    uint64_t head_ = 0;
+};
+
+#ifndef CPU_SIM_PROBE_RING
+#define CPU_SIM_PROBE_RING 4096
+#endif
+
+using SimProbeRing = ProbeRing<CPU_SIM_PROBE_RING>;
+
+#if CPU_SIM_PROBES
+SimProbeRing& probe_ring();
+#define SIM_PROBE(kind, cycle, ins, arg) \
+    probe_ring().push(ProbeEvent{(cycle), (ins).id, (ins).pc, (int32_t)(arg), (kind)})
+#else
+#define SIM_PROBE(kind, cycle, ins, arg) ((void)0)
+#endif
+
+// Write the retained events as CSV text (no allocation, so it is also used
+// from the crash handler). No-op when probes are compiled out.
+void probe_dump(std::FILE* out);
+
+// Dump the ring to stderr on SIGSEGV/SIGABRT/SIGFPE. No-op when compiled out.
+void probe_install_crash_handler();
@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Fixed-depth circular return address stack, updated speculatively at ID.
+//
+// Calls push their return PC, returns pop the predicted target. A push onto a
+// full stack overwrites the oldest entry (overflow); a pop of an empty stack
+// has nothing to predict (underflow). Every predicted control instruction
+// keeps a checkpoint (top index, depth, top entry) taken right after its own
+// push/pop; repairing to it on a mispredict undoes whatever the wrong path did.
+// A configured depth of 0 (no RAS) is handled by the caller, which skips it.
+class ReturnAddressStack {
+public:
+    static constexpr int kMaxDepth = 64;
+
+    struct Checkpoint {
+        int32_t top = 0;
+        int32_t count = 0;
+        int32_t top_value = -1;
+    };
+
+    explicit ReturnAddressStack(int depth = 16)
+    : depth_(depth < 1 ? 1 : depth > kMaxDepth ? kMaxDepth : depth) {}
+
+    int depth() const { return depth_; }
+
+    // Returns false if the oldest entry was overwritten
+    bool push(int ret_pc) {
+        top_ = (top_ + 1) % depth_;
+        stack_[top_] = ret_pc;
+        if (count_ == depth_) return false;
+        count_++;
+        return true;
+    }
+
+    // Returns false (and leaves `target` alone) on underflow
+    bool pop(int& target) {
+        if (count_ == 0) return false;
+        target = stack_[top_];
+        top_ = (top_ + depth_ - 1) % depth_;
+        count_--;
+        return true;
+    }
+
+    Checkpoint checkpoint() const { return {top_, count_, stack_[top_]}; }
+    void repair(const Checkpoint& c) {
+        top_ = c.top;
+        count_ = c.count;
+        stack_[top_] = c.top_value;
+    }
+
+    // Live entries, top first (for state hashing)
+    template <typename F>
+    void for_each(F&& f) const {
+        f(count_);
+        for (int i = 0; i < count_; ++i) f(stack_[(top_ + depth_ - i) % depth_]);
+    }
+
+private:
+    std::array<int32_t, kMaxDepth> stack_{};
+    int32_t top_ = 0;
+    int32_t count_ = 0;
+    int32_t depth_;
+};
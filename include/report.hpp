@@ -0,0 +1,74 @@
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+#include "metrics.hpp"
+#include "intervals.hpp"
+#include "host_perf.hpp"
+#include "predictor.hpp"
+#include "pipeline.hpp"
+#include "energy.hpp"
+#include "timing.hpp"
+
+// What was simulated (echoed into reports)
+struct RunInfo {
+    std::string trace;
+    std::string predictor;
+    PipelineConfig pipeline;
+    uint64_t max_cycles = 0;
+    uint64_t interval_cycles = 0;
+    EnergyModel energy;
+    TimingModel timing;
+};
+
+// Host-side profile of the simulator run (see HostPerf)
+struct HostReport {
+    bool requested = false;      // --host-perf given
+    bool available = false;      // at least one counter opened
+    std::string error;
+    std::vector<HostPhase> phases;
+};
+
+// One named value of a report. Names are dotted paths ("metrics.stalls.raw");
+// JSON writers nest on the dots, the binary writer keeps them flat.
+struct ReportField {
+    enum Kind : uint8_t { U64 = 0, F64 = 1, Str = 2 };
+    std::string name;
+    Kind kind = U64;
+    uint64_t u = 0;
+    double d = 0.0;
+    std::string s;
+};
+
+// Flattened views used by every report (add new counters here)
+void append_run_fields(std::vector<ReportField>& out, const RunInfo& run);
+void append_metrics_fields(std::vector<ReportField>& out, const Metrics& m);
+void append_predictor_fields(std::vector<ReportField>& out, const BranchPredictor& bp);
+// Energy of the run under run.energy (energy.*): per event kind, total, per instruction, power
+void append_energy_fields(std::vector<ReportField>& out, const RunInfo& run, const Metrics& m);
+
+// Wall-clock time of the run under run.timing (timing.*, only with a timing model):
+// clock period, time per instruction, and the --depth-sweep estimates with the
+// throughput-optimal depth
+void append_timing_fields(std::vector<ReportField>& out, const RunInfo& run, const Metrics& m);
+
+// Machine-readable run statistics (--stats <json>)
+void write_stats_json(std::ostream& os, const RunInfo& run, const Metrics& m,
+                      const HostReport& host);
+
+// Summary sidecar written next to every timeline CSV, so viewers don't have to
+// rescan the timeline: configuration, full metrics, predictor stats and the
+// per-interval series.
+//   JSON:   { "config":{...}, "predictor":{...}, "metrics":{...},
+//             "intervals":{"columns":[...], "rows":[[...],...]} }
+//   binary: "CPUSIMS\1", u32 field count,
+//           fields: u8 kind, u16 name length, name, value (u64 | f64 | u32 length + bytes),
+//           u32 column count, columns: u16 length + name,
+//           u32 row count, rows: column count * u64            (all little-endian)
+void write_summary_json(std::ostream& os, const RunInfo& run, const Metrics& m,
+                        const BranchPredictor& bp, const std::vector<IntervalSample>& series);
+void write_summary_bin(std::ostream& os, const RunInfo& run, const Metrics& m,
+                       const BranchPredictor& bp, const std::vector<IntervalSample>& series);
+
+// Sidecar paths for a timeline: data/x.csv -> data/x.summary.json / data/x.summary.bin
+std::string summary_path(const std::string& timeline_csv, const std::string& ext);
@@ -0,0 +1,67 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Structural resources, one bit per unit per cycle. A row is what is taken in
+// one cycle; the ring reaches kRows - 1 cycles ahead, so an instruction can book
+// everything it will need (the divider for its EX cycles, a register file write
+// port at WB) when it leaves ID, and a younger one collides with a single AND.
+//   bit 0      memory port (--mem-ports unified: shared by IF and the data side)
+//   bit 1      divider (a DIV keeps EX for div_cycles)
+//   bits 8-15  register file read ports
+//   bits 16-23 register file write ports
+class ReservationTable {
+public:
+    static constexpr int kRows = 64;
+    static constexpr int kMaxPorts = 8;
+    static constexpr uint32_t kMemPort = 1u << 0;
+    static constexpr uint32_t kDivider = 1u << 1;
+
+    static constexpr uint32_t read_ports(int n) { return ((1u << n) - 1) << 8; }
+    static constexpr uint32_t write_ports(int n) { return ((1u << n) - 1) << 16; }
+
+    bool free(uint64_t cycle, uint32_t mask) const { return !(row(cycle) & mask); }
+    void reserve(uint64_t cycle, uint32_t mask) { row(cycle) |= mask; }
+    int free_units(uint64_t cycle, uint32_t units) const {
+        int n = 0;
+        for (uint32_t avail = units & ~row(cycle); avail; avail &= avail - 1) ++n;
+        return n;
+    }
+
+    // Takes up to `n` free units out of `units` in `cycle`; returns how many it got
+    int claim(uint64_t cycle, uint32_t units, int n) {
+        int got = 0;
+        for (uint32_t avail = units & ~row(cycle); avail && got < n; avail &= avail - 1, ++got)
+            row(cycle) |= avail & -avail;
+        return got;
+    }
+
+    // Called when `cycle` is over: its row comes back as cycle + kRows
+    void retire(uint64_t cycle) { row(cycle) = 0; }
+
+    // Everything from MEM back was held in `now`: what it booked for later cycles
+    // moves back one, and a division due to start in `now` starts a cycle later.
+    // (A write overflow of the slot that retired in `now` moves too, into the
+    // held slot's WB cycle, which no younger slot can have booked.)
+    void slip(uint64_t now) {
+        for (uint64_t c = now + kRows - 1; c > now + 1; --c) row(c) = row(c - 1);
+        row(now + 1) = row(now) & kDivider;
+    }
+
+    // Drops every booking after `now` (the instructions that made them were squashed)
+    void clear_after(uint64_t now) {
+        for (uint64_t c = now + 1; c < now + kRows; ++c) row(c) = 0;
+    }
+
+    // Rows from `now` on, up to the one retire() is about to recycle (for state hashing)
+    template <typename F>
+    void for_each(uint64_t now, F&& f) const {
+        for (uint64_t c = now; c < now + kRows - 1; ++c) f(row(c));
+    }
+
+private:
+    uint32_t& row(uint64_t cycle) { return rows_[cycle % kRows]; }
+    uint32_t  row(uint64_t cycle) const { return rows_[cycle % kRows]; }
+
+    std::array<uint32_t, kRows> rows_{};
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+// One retirement read back from a timeline CSV (the WB column)
+struct RetireEvent {
+    uint64_t cycle = 0;
+    int pc = -1;              // "OP#<pc>": timeline ids are static PCs
+    std::string op;
+};
+
+// Streams the retirements of a timeline CSV, one row at a time; a fused WB
+// cell is two retirements (the head's PC and the next one)
+class RetireReader {
+public:
+    std::optional<std::string> open(const std::string& path);
+    // Next retirement in order; false at end of file
+    bool next(RetireEvent& ev);
+    // Last cycle number seen so far (the run length once next() returned false)
+    uint64_t last_cycle() const { return last_cycle_; }
+    const std::string& error() const { return error_; }
+
+private:
+    std::ifstream in_;
+    std::string path_;
+    std::string line_;
+    int wb_col_ = -1;
+    uint64_t line_no_ = 1;
+    uint64_t last_cycle_ = 0;
+    std::string error_;
+    RetireEvent tail_;        // second half of the last fused cell, not yet returned
+    bool has_tail_ = false;
+};
+
+// Cycles one static instruction gained or lost in B relative to A
+struct PcDelta {
+    std::string op;
+    uint64_t count = 0;     // dynamic instances aligned
+    int64_t cycles = 0;     // sum of local deltas (> 0: B slower here)
+};
+
+struct DiffResult {
+    uint64_t cycles_a = 0, cycles_b = 0;
+    uint64_t aligned = 0;                 // dynamic instructions compared
+    uint64_t only_a = 0, only_b = 0;      // retirements past the end of the other run
+
+    // First dynamic instruction whose retire cycle differs
+    bool diverged = false;
+    uint64_t div_index = 0;
+    RetireEvent div_a, div_b;
+
+    // First dynamic instruction where the two runs retire different PCs.
+    // Alignment stops there: later deltas would compare unrelated instructions.
+    bool path_mismatch = false;
+    uint64_t path_index = 0;
+    RetireEvent path_a, path_b;
+
+    int64_t min_delta = 0, max_delta = 0; // retire_b - retire_a over aligned instructions
+    int64_t final_delta = 0;
+
+    std::unordered_map<int, PcDelta> per_pc;
+};
+
+// Aligns two timelines of the same trace by dynamic instruction (the n-th
+// retirement of A against the n-th of B; the pipeline retires in order).
+// Both files are streamed; memory is bounded by the number of distinct PCs.
+// If `per_instr` is given, one CSV row per aligned instruction is written to it:
+//   index,pc,op,retire_a,retire_b,delta,local
+// where local is the change in delta at this instruction (what it gained or lost).
+std::optional<std::string> diff_runs(const std::string& path_a, const std::string& path_b,
+                                     DiffResult& out, std::ostream* per_instr = nullptr);
+
+// Human-readable summary with the `top` PCs that lost / gained most
+void print_diff_report(std::ostream& os, const DiffResult& r, size_t top = 10);
@@ -0,0 +1,85 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "instr.hpp"
+
+// Toy effective address of a LOAD/STORE. Registers carry no values in this
+// model, so the base register number stands in for its contents:
+// [r2+8] and [r2+8] alias, [r2+8] and [r3+8] don't.
+inline int64_t effective_address(const Instruction& ins) {
+    return ((int64_t)ins.rs1 << 8) + ins.imm;
+}
+constexpr int kAccessBytes = 4;   // every access is one word
+
+inline bool accesses_overlap(int64_t a, int64_t b) {
+    return a - b > -kAccessBytes && a - b < kAccessBytes;
+}
+
+// Finite FIFO of committed stores waiting to be written to the data cache.
+// Stores enter from MEM; the oldest drains every `drain_cycles`. Loads in MEM
+// search it like a CAM: all entries are compared at once into a bitmask, and
+// the youngest overlapping store decides the outcome.
+class StoreBuffer {
+public:
+    static constexpr int kMaxEntries = 32;   // one bit per entry in a uint32_t
+    enum class Lookup { Miss, Forward, Partial };
+
+    StoreBuffer(int entries = 0, int drain_cycles = 1)
+    : cap_(entries < 0 ? 0 : entries > kMaxEntries ? kMaxEntries : entries),
+      drain_(drain_cycles < 1 ? 1 : drain_cycles) {}
+
+    bool enabled() const { return cap_ > 0; }
+    bool full() const { return count_ == cap_; }
+    int  size() const { return count_; }
+
+    // Free the stores whose cache write has completed by cycle `now`
+    void drain(uint64_t now) {
+        while (count_ > 0 && head_done_ <= now) {
+            valid_ &= ~(1u << head_);
+            head_ = (head_ + 1) % kMaxEntries;
+            count_--;
+            head_done_ = now + drain_;   // next store starts its write now
+        }
+    }
+
+    void push(int64_t addr, uint64_t now) {
+        const int slot = (head_ + count_) % kMaxEntries;
+        addr_[slot] = addr;
+        valid_ |= 1u << slot;
+        if (count_++ == 0) head_done_ = now + drain_;
+    }
+
+    // Exact match with the youngest overlapping store forwards its data; any
+    // other overlap has to wait for that store to drain.
+    Lookup lookup(int64_t addr) const {
+        uint32_t overlap = 0, exact = 0;
+        for (int i = 0; i < kMaxEntries; ++i) {
+            overlap |= (uint32_t)accesses_overlap(addr_[i], addr) << i;
+            exact   |= (uint32_t)(addr_[i] == addr) << i;
+        }
+        overlap &= valid_;
+        if (!overlap) return Lookup::Miss;
+        // Rotate so the oldest entry is bit 0; the highest set bit is then the youngest
+        const uint64_t rot = ((uint64_t)overlap | ((uint64_t)overlap << kMaxEntries)) >> head_;
+        int young = 31;
+        while (!((rot >> young) & 1)) --young;
+        const int slot = (head_ + young) % kMaxEntries;
+        return ((exact >> slot) & 1) ? Lookup::Forward : Lookup::Partial;
+    }
+
+    // Occupied entries oldest first, plus cycles until the head drains (for state hashing)
+    template <typename F>
+    void for_each(uint64_t now, F&& f) const {
+        f(count_ ? (int64_t)(head_done_ - now) : 0);
+        for (int i = 0; i < count_; ++i) f(addr_[(head_ + i) % kMaxEntries]);
+    }
+
+private:
+    std::array<int64_t, kMaxEntries> addr_{};
+    uint32_t valid_ = 0;
+    int head_ = 0;
+    int count_ = 0;
+    int cap_;
+    int drain_;
+    uint64_t head_done_ = 0;   // cycle the head entry's write completes
+};
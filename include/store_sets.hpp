@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Store-set memory dependence predictor (Chrysos & Emer), in fixed-size tables.
+//
+//   SSIT: PC -> store set id, shared by loads and stores that once conflicted
+//   LFST: store set id -> the youngest in-flight store of that set (0 = none)
+//
+// A load whose set has an in-flight store is predicted dependent and waits;
+// after a memory-order violation the load and the store are put in one set.
+class StoreSets {
+public:
+    static constexpr int kSsitSize = 1024;
+    static constexpr int kLfstSize = 128;
+    static constexpr uint16_t kNoSet = 0xffff;
+
+    StoreSets() { ssit_.fill(kNoSet); }
+
+    // Store issued / written to the store buffer; `inum` identifies the dynamic store
+    void store_issued(int pc, uint64_t inum) {
+        const uint16_t s = ssit_[slot(pc)];
+        if (s != kNoSet) lfst_[s] = inum;
+    }
+    void store_done(int pc, uint64_t inum) {
+        const uint16_t s = ssit_[slot(pc)];
+        if (s != kNoSet && lfst_[s] == inum) lfst_[s] = 0;
+    }
+
+    bool load_must_wait(int pc) const {
+        const uint16_t s = ssit_[slot(pc)];
+        return s != kNoSet && lfst_[s] != 0;
+    }
+
+    // Load at `load_pc` read memory before the store at `store_pc` wrote it
+    void violation(int load_pc, int store_pc) {
+        uint16_t& ls = ssit_[slot(load_pc)];
+        uint16_t& ss = ssit_[slot(store_pc)];
+        if (ls == kNoSet && ss == kNoSet) {
+            ls = ss = next_;
+            next_ = (uint16_t)((next_ + 1) % kLfstSize);
+        } else if (ls == kNoSet) {
+            ls = ss;
+        } else if (ss == kNoSet) {
+            ss = ls;
+        } else {
+            ls = ss = ls < ss ? ls : ss;   // merge: both take the smaller id
+        }
+    }
+
+    // Valid sets and in-flight markers (for state hashing; ages relative to `now`)
+    template <typename F>
+    void for_each(uint64_t now, F&& f) const {
+        for (int i = 0; i < kSsitSize; ++i) if (ssit_[i] != kNoSet) f(((uint64_t)i << 16) | ssit_[i]);
+        for (int i = 0; i < kLfstSize; ++i) if (lfst_[i]) f(((uint64_t)i << 48) | (now - lfst_[i]));
+        f(next_);
+    }
+
+private:
+    static int slot(int pc) { return (int)((uint32_t)pc % kSsitSize); }
+
+    std::array<uint16_t, kSsitSize> ssit_;
+    std::array<uint64_t, kLfstSize> lfst_{};
+    uint16_t next_ = 0;
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "pipeline.hpp"
+#include "predictor.hpp"
+
+// Periodic snapshots of a running Pipeline (and its predictor) for rewinding.
+//
+// record() after every step keeps a snapshot each `every` cycles. Pipeline
+// state is serialized field by field (Pipeline::save_state, so disabled
+// components cost nothing); predictor tables, the indirect target predictor's
+// included, are stored as a sorted key frame shared by the following
+// snapshots, each of which only keeps the entries that changed since (a new
+// key frame is cut when the delta grows too large).
+// seek() restores the nearest snapshot at or before the target and replays
+// forward, so rewinding costs at most `every` steps.
+//
+// Memory stays under `budget_bytes`: when it would be exceeded, every other
+// snapshot is dropped and the interval doubles.
+class TimeTravel {
+public:
+    TimeTravel(Pipeline& pipe, BranchPredictor* bp, uint64_t every, size_t budget_bytes);
+
+    // Call once before the first step and after each step
+    void record();
+
+    // Bring the pipeline to the state right after `cycle` steps. Returns false
+    // if the run halts before reaching it (the pipeline is left at the halt) or
+    // the snapshot it needs doesn't restore (the pipeline state is then undefined).
+    bool seek(uint64_t cycle);
+    // One cycle back; false at cycle 0
+    bool step_back();
+
+    size_t snapshots() const { return snaps_.size(); }
+    size_t bytes() const { return bytes_; }
+    uint64_t every() const { return every_; }
+
+private:
+    struct Snapshot {
+        uint64_t cycle = 0;
+        std::string pipe;                            // Pipeline::save_state, indirect tables left out
+        int bp_total = 0, bp_miss = 0;
+        std::shared_ptr<const PredictorState> base;   // key frame (sorted)
+        PredictorState changed;                      // entries added/changed since base
+        std::vector<uint64_t> removed;               // keys gone since base
+    };
+
+    static constexpr int kMaxSinceKey = 16;
+    // Table numbers of the indirect predictor's entries, above any direction predictor's
+    static constexpr uint32_t kIndirectTables = 1u << 16;
+
+    bool restore(const Snapshot& s);
+    void enforce_budget();
+    size_t recount() const;
+
+    Pipeline& pipe_;
+    BranchPredictor* bp_;
+    uint64_t every_;
+    size_t budget_;
+    size_t bytes_ = 0;
+    int since_key_ = 0;
+    std::vector<Snapshot> snaps_;   // ascending cycle
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "metrics.hpp"
+#include "pipeline.hpp"
+
+// The five stages the simulator models, as far as timing is concerned
+enum class PipeStage : uint8_t { IF, ID, EX, MEM, WB, Count };
+constexpr int kNumPipeStages = (int)PipeStage::Count;
+
+inline const char* pipe_stage_name(PipeStage s) {
+    switch (s) {
+        case PipeStage::IF:  return "if";
+        case PipeStage::ID:  return "id";
+        case PipeStage::EX:  return "ex";
+        case PipeStage::MEM: return "mem";
+        case PipeStage::WB:  return "wb";
+        default:             return "?";
+    }
+}
+
+// Logic delay of each stage and the overhead every pipeline latch adds (setup,
+// clock-to-q, skew), in picoseconds. Like the energy model it is applied once,
+// after the run. The defaults are rough figures for a simple 45 nm core;
+// --timing <file> replaces any of them.
+struct TimingModel {
+    std::array<double, kNumPipeStages> logic_ps{
+        280.0,  // if:  I-cache read, next-PC
+        220.0,  // id:  decode, register read
+        320.0,  // ex:  ALU, branch compare
+        300.0,  // mem: D-cache read
+        120.0,  // wb:  register write
+    };
+    double latch_ps = 40.0;
+    int sweep_depth = 0;    // --depth-sweep: deepest pipeline to estimate (0 = no sweep)
+    bool enabled = false;   // --timing or --depth-sweep given; energy then runs at this clock
+};
+
+// "<stage> = <ps>" and "latch = <ps>" lines; '#' starts a comment
+std::optional<std::string> load_timing_model(const std::string& path, TimingModel& out);
+
+// How many pipeline stages each of the five becomes (1 each = the simulated pipe)
+struct StageSplit {
+    std::array<int, kNumPipeStages> pieces{1, 1, 1, 1, 1};
+    int depth() const {
+        int d = 0;
+        for (int k : pieces) d += k;
+        return d;
+    }
+};
+
+// The split of `depth` (>= 5) stages with the shortest clock: each extra stage
+// goes to the stage whose pieces are currently the slowest
+StageSplit split_for_depth(const TimingModel& t, int depth);
+
+// Clock period of a split: the slowest piece plus one latch
+double clock_period_ps(const TimingModel& t, const StageSplit& s);
+PipeStage limiting_stage(const TimingModel& t, const StageSplit& s);
+
+// One pipeline depth, timed. The simulated run is depth 5; deeper splits are
+// estimated from its CPI stack rather than simulated: each component is scaled
+// by how its penalty grows with the stages it spans (control: fetch to branch
+// resolution, load_use: EX and MEM, raw: EX to WB). Fetch and memory stalls,
+// and the divider's share of the structural ones, keep their time in ns (so
+// their cycles grow as the clock shrinks); base cycles and port conflicts stay.
+struct TimingPoint {
+    int depth = 5;
+    StageSplit split;
+    double period_ps = 0.0;
+    PipeStage limit = PipeStage::IF;
+    double cycles = 0.0;
+    double cpi = 0.0;
+    double tpi_ps = 0.0;     // time per retired instruction
+    double seconds = 0.0;    // wall-clock time of the run
+};
+TimingPoint time_run(const TimingModel& t, const PipelineConfig& cfg, const Metrics& m, int depth = 5);
+
+// Depths 5..t.sweep_depth (empty without a sweep)
+std::vector<TimingPoint> sweep_depths(const TimingModel& t, const PipelineConfig& cfg, const Metrics& m);
+
+// The throughput-optimal point of a non-empty sweep: least time per instruction
+const TimingPoint& best_depth(const std::vector<TimingPoint>& sweep);
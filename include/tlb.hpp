@@ -0,0 +1,78 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Set-associative, LRU translation buffer over fixed-size arrays. Keys are
+// virtual page numbers (or, in the page-walk cache, level-tagged VPN prefixes).
+class Tlb {
+public:
+    static constexpr int kMaxEntries = 1024;
+    static constexpr int kMaxWays = 16;
+
+    Tlb(int entries = 0, int ways = 4) {
+        ways_ = ways < 1 ? 1 : ways > kMaxWays ? kMaxWays : ways;
+        entries = entries < 0 ? 0 : entries > kMaxEntries ? kMaxEntries : entries;
+        sets_ = entries / ways_;
+        if (sets_ == 0 && entries > 0) { sets_ = 1; ways_ = entries; }
+    }
+
+    bool enabled() const { return sets_ > 0; }
+
+    bool probe(uint64_t key) const { return find(key) >= 0; }
+    // Hit updates recency; a miss does not fill (see insert)
+    bool lookup(uint64_t key) {
+        const int i = find(key);
+        if (i < 0) return false;
+        entries_[i].stamp = ++tick_;
+        return true;
+    }
+    void insert(uint64_t key) {
+        Entry* set = &entries_[(size_t)set_of(key) * ways_];
+        Entry* victim = &set[0];
+        for (int w = 0; w < ways_; ++w) {
+            if (!set[w].valid) { victim = &set[w]; break; }
+            if (set[w].stamp < victim->stamp) victim = &set[w];
+        }
+        *victim = Entry{key, ++tick_, true};
+    }
+
+    // Valid entries as (slot, key, age), for state hashing
+    template <typename F>
+    void for_each(F&& f) const {
+        for (int i = 0; i < sets_ * ways_; ++i)
+            if (entries_[i].valid) f((uint64_t)i, entries_[i].key, tick_ - entries_[i].stamp);
+    }
+
+private:
+    struct Entry {
+        uint64_t key = 0;
+        uint64_t stamp = 0;
+        bool valid = false;
+    };
+
+    int set_of(uint64_t key) const { return (int)((key ^ (key >> 16)) % (uint64_t)sets_); }
+    int find(uint64_t key) const {
+        if (!enabled()) return -1;
+        const int base = set_of(key) * ways_;
+        for (int w = 0; w < ways_; ++w)
+            if (entries_[base + w].valid && entries_[base + w].key == key) return base + w;
+        return -1;
+    }
+
+    std::array<Entry, kMaxEntries> entries_{};
+    int sets_ = 0;
+    int ways_ = 1;
+    uint64_t tick_ = 0;
+};
+
+// Radix page table walked on an L2 TLB miss: `levels` levels of 9 VPN bits
+// each, one memory reference of `level_cycles` per level. The page-walk cache
+// keeps the upper-level (non-leaf) entries, keyed by level and VPN prefix; the
+// walk starts below the deepest level it hits, so a hit on the level right
+// above the leaf leaves a single reference.
+constexpr int kPageLevelBits = 9;
+constexpr int kInstrBytes = 4;   // instruction fetch address = pc * kInstrBytes
+
+inline uint64_t pwc_key(int level, uint64_t vpn) {
+    return ((uint64_t)level << 56) | ((vpn >> (kPageLevelBits * (level - 1))) & ((1ull << 56) - 1));
+}
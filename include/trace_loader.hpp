@@ -3,8 +3,59 @@
 #include <vector>
 #include <optional>
 #include "instr.hpp"
+#include "instr_source.hpp"
+
+// Max nesting of REPEAT blocks in a trace
+constexpr int kMaxRepeatDepth = 8;
+
+// A parsed trace, kept in its compact form.
+//
+// Grammar on top of the plain one-instruction-per-line format:
+//   REPEAT <n> [var] {      # body is repeated n times
+//     ADD r{var+1} r{var} r2  # r{var+k} -> register (k + iteration) mod kNumRegs
+//   }
+// Blocks nest. Nothing is expanded at load time: at(pc) walks the block tree
+// and instantiates the instruction for that PC, so memory is bounded by the
+// size of the file, not by the length of the dynamic stream.
+// Expanded PCs (and ids) are positions in the unrolled stream; branch offsets
+// are relative to that stream as well.
+class TraceProgram : public InstructionSource {
+public:
+    int size() const override { return size_; }
+    Instruction at(int pc) const override;
+
+private:
+    friend std::optional<std::string> load_trace(const std::string&, TraceProgram&);
+
+    // Register operand, optionally renamed by an enclosing loop variable
+    struct RegRef {
+        int reg = -1;
+        int var = -1;   // depth of the loop variable, -1 = plain register
+    };
+
+    struct Node {
+        // Plain instruction (count == 0)
+        Instruction ins;
+        RegRef rd, rs1, rs2;
+
+        // REPEAT block (count > 0); the whole file is an implicit block
+        int count = 0;
+        int depth = -1;                 // loop variable depth, -1 for the root
+        std::vector<int> kids;          // node indices of the body
+        std::vector<long long> kid_off; // expanded offset of each kid within one iteration
+        long long body_len = 0;         // expanded length of one iteration
+    };
+
+    std::vector<Node> nodes_;  // nodes_[0] is the root
+    int size_ = 0;
+};
 
 // Loads a text trace and returns parsed instructions, or error string.
+std::optional<std::string> load_trace(
+    const std::string& path,
+    TraceProgram& out);
+
+// Same, but fully expanded into a vector (small traces only).
 std::optional<std::string> load_trace(
     const std::string& path,
     std::vector<Instruction>& out);
@@ -0,0 +1,112 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include "instr.hpp"
+
+// Victim choice when a micro-op cache set is full
+enum class UopReplacement : uint8_t {
+    Lru,      // least recently hit or filled
+    Fifo,     // oldest fill
+    Random,   // xorshift, deterministic per run
+};
+
+inline const char* uop_replacement_name(UopReplacement r) {
+    switch (r) {
+        case UopReplacement::Lru:    return "lru";
+        case UopReplacement::Fifo:   return "fifo";
+        case UopReplacement::Random: return "random";
+    }
+    return "?";
+}
+
+inline bool parse_uop_replacement(const std::string& s, UopReplacement& out) {
+    for (UopReplacement r : {UopReplacement::Lru, UopReplacement::Fifo, UopReplacement::Random})
+        if (s == uop_replacement_name(r)) { out = r; return true; }
+    return false;
+}
+
+// Decoded-instruction (micro-op) cache: set-associative, indexed and tagged by
+// PC, one decoded instruction per line. A hit hands the Instruction straight
+// to the pipeline, so neither the instruction source nor the decoders run.
+// Ages are kept as a use counter rather than cycles, so state hashes of two
+// runs match whenever their caches saw the same sequence of accesses.
+class UopCache {
+public:
+    static constexpr int kMaxEntries = 1024;
+    static constexpr int kMaxWays = 16;
+
+    UopCache(int entries = 0, int ways = 8, UopReplacement repl = UopReplacement::Lru)
+    : repl_(repl) {
+        ways_ = ways < 1 ? 1 : ways > kMaxWays ? kMaxWays : ways;
+        entries = entries < 0 ? 0 : entries > kMaxEntries ? kMaxEntries : entries;
+        sets_ = entries / ways_;
+        if (sets_ == 0 && entries > 0) { sets_ = 1; ways_ = entries; }
+    }
+
+    bool enabled() const { return sets_ > 0; }
+    int entries() const { return sets_ * ways_; }
+    int ways() const { return ways_; }
+
+    // Decoded instruction at `pc`, or nullptr on a miss
+    const Instruction* lookup(int pc) {
+        Line* l = find(pc);
+        if (!l) return nullptr;
+        if (repl_ == UopReplacement::Lru) l->stamp = ++tick_;
+        return &l->ins;
+    }
+    // Same, without counting as a use
+    bool contains(int pc) const { return const_cast<UopCache*>(this)->find(pc) != nullptr; }
+
+    // Fill after a miss; returns true if a valid line was evicted
+    bool insert(const Instruction& ins) {
+        Line* set = &lines_[(size_t)set_of(ins.pc) * ways_];
+        Line* victim = nullptr;
+        for (int w = 0; w < ways_ && !victim; ++w)
+            if (!set[w].valid) victim = &set[w];
+        const bool evict = victim == nullptr;
+        if (evict) {
+            if (repl_ == UopReplacement::Random) {
+                rng_ ^= rng_ << 13; rng_ ^= rng_ >> 17; rng_ ^= rng_ << 5;
+                victim = &set[rng_ % (uint32_t)ways_];
+            } else {
+                victim = &set[0];
+                for (int w = 1; w < ways_; ++w)
+                    if (set[w].stamp < victim->stamp) victim = &set[w];
+            }
+        }
+        *victim = Line{ins, ++tick_, true};
+        return evict;
+    }
+
+    // Valid lines as (slot, instruction, age), for state hashing
+    template <typename F>
+    void for_each(F&& f) const {
+        for (int i = 0; i < sets_ * ways_; ++i)
+            if (lines_[i].valid) f(i, lines_[i].ins, tick_ - lines_[i].stamp);
+    }
+    uint32_t rng_state() const { return rng_; }
+
+private:
+    struct Line {
+        Instruction ins{Opcode::NOP};
+        uint64_t stamp = 0;   // tick of the last use (LRU) or of the fill (FIFO)
+        bool valid = false;
+    };
+
+    int set_of(int pc) const { return (int)((uint32_t)pc % (uint32_t)sets_); }
+    Line* find(int pc) {
+        if (!enabled()) return nullptr;
+        Line* set = &lines_[(size_t)set_of(pc) * ways_];
+        for (int w = 0; w < ways_; ++w)
+            if (set[w].valid && set[w].ins.pc == pc) return &set[w];
+        return nullptr;
+    }
+
+    std::array<Line, kMaxEntries> lines_{};
+    int sets_ = 0;
+    int ways_ = 1;
+    UopReplacement repl_;
+    uint64_t tick_ = 0;
+    uint32_t rng_ = 2463534242u;
+};
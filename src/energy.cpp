@@ -0,0 +1,50 @@
+#include "energy.hpp"
+#include "file_io.hpp"
+
+uint64_t energy_event_count(const Metrics& m, EnergyEvent e) {
+    switch (e) {
+        case EnergyEvent::Fetch:    // I-cache reads only: hits below are charged as their own reads
+            return m.frontend.fetches - m.frontend.lsd_hits - m.frontend.uop_hits;
+        case EnergyEvent::Decode:   return m.frontend.decodes;
+        case EnergyEvent::UopRead:  return m.frontend.uop_hits;
+        case EnergyEvent::LsdRead:  return m.frontend.lsd_hits;
+        case EnergyEvent::RegRead:  return m.activity.rf_reads;
+        case EnergyEvent::RegWrite: return m.activity.rf_writes;
+        case EnergyEvent::Alu:      return m.retired;   // one operation per instruction
+        case EnergyEvent::L1d:
+            return m.mem.loads - m.mem.stlf_forwards + m.mem.stores + m.wrong_path.loads;
+        case EnergyEvent::L2:       return m.mem.dcache_misses + m.wrong_path.fills;
+        case EnergyEvent::Tlb:      return m.tlb.itlb_accesses + m.tlb.dtlb_accesses;
+        case EnergyEvent::WalkRef:  return m.tlb.walk_refs;
+        case EnergyEvent::Flush:    return m.activity.flushes;
+        case EnergyEvent::Cycle:    return m.cycles;
+        default:                    return 0;
+    }
+}
+
+std::optional<std::string> load_energy_model(const std::string& path, EnergyModel& out) {
+    return load_key_values(path, "energy model", [&](const std::string& key, double v) -> std::optional<std::string> {
+        if (key == "clock_ghz") {
+            if (v <= 0.0) return "clock_ghz must be positive";
+            out.clock_ghz = v;
+            return std::nullopt;
+        }
+        int e = 0;
+        while (e < kNumEnergyEvents && key != energy_event_name((EnergyEvent)e)) ++e;
+        if (e == kNumEnergyEvents) return "unknown energy event '" + key + "'";
+        out.pj[e] = v;
+        return std::nullopt;
+    });
+}
+
+EnergyReport estimate_energy(const EnergyModel& model, const Metrics& m) {
+    EnergyReport r;
+    for (int e = 0; e < kNumEnergyEvents; ++e) {
+        r.pj[e] = model.pj[e] * (double)energy_event_count(m, (EnergyEvent)e);
+        r.total_pj += r.pj[e];
+    }
+    r.epi_pj = m.retired ? r.total_pj / (double)m.retired : 0.0;
+    r.seconds = (double)m.cycles / (model.clock_ghz * 1e9);
+    r.power_mw = m.cycles ? r.total_pj * model.clock_ghz / (double)m.cycles : 0.0;   // pJ/ns = mW
+    return r;
+}
@@ -5,7 +5,10 @@ static inline bool writes_reg(const Instruction& ins) {
     switch (ins.op) {
         case Opcode::ADD:
         case Opcode::SUB:
+        case Opcode::DIV:
         case Opcode::LOAD:
+        case Opcode::JAL:   // link
+        case Opcode::JALR:
             return ins.rd >= 0;
         default:
             return false;
@@ -14,14 +17,19 @@ static inline bool writes_reg(const Instruction& ins) {
 static inline int dest_reg(const Instruction& ins) {
     return (writes_reg(ins) ? ins.rd : -1);
 }
+// Second half of a fused macro-op: one more source, maybe one more result
+static inline int fused_src(const Instruction& ins) { return ins.fused ? ins.rs3 : -1; }
+static inline int fused_dest(const Instruction& ins) { return ins.fused ? ins.rd2 : -1; }
 static inline bool reads_r1(const Instruction& ins) {
     switch (ins.op) {
         case Opcode::ADD:
         case Opcode::SUB:
+        case Opcode::DIV:
         case Opcode::LOAD:  // base address
         case Opcode::STORE:
         case Opcode::BEQ:
         case Opcode::BNE:
+        case Opcode::JALR:  // jump base
             return ins.rs1 >= 0;
         default: return false;
     }
@@ -30,6 +38,7 @@ static inline bool reads_r2(const Instruction& ins) {
     switch (ins.op) {
         case Opcode::ADD:
         case Opcode::SUB:
+        case Opcode::DIV:
         case Opcode::STORE:
         case Opcode::BEQ:
         case Opcode::BNE:
@@ -38,54 +47,110 @@ static inline bool reads_r2(const Instruction& ins) {
     }
 }
 
+int reg_reads(const Instruction& ins) {
+    return (int)reads_r1(ins) + (int)reads_r2(ins) + (fused_src(ins) >= 0);
+}
+int reg_writes(const Instruction& ins) {
+    return (dest_reg(ins) > 0) + (fused_dest(ins) > 0);   // r0 is hardwired
+}
+
+// How one source operand gets its value this cycle
+struct OperandRoute {
+    bool stall = false;
+    bool load_use = false;
+    int path = -1;      // the bypass used or, when stalled, the one that was missing
+};
+
+// Producer `dist` stages ahead of ID (1 = EX, 2 = MEM, 3 = WB). A stall is
+// repeated next cycle with the producer one stage further, so each case only
+// asks whether the value can be caught this time.
+static OperandRoute route_operand(const Instruction& prod, int dist, uint8_t paths,
+                                  bool store_data, bool branch,
+                                  bool ex_load_early, bool mem_load_ready) {
+    const auto has = [&](BypassPath p) { return (paths & (1u << (int)p)) != 0; };
+    const bool load = prod.op == Opcode::LOAD;
+    // Waiting on a LOAD's data is load-use only where an ALU result would have been forwarded
+    const bool load_use = has(BypassPath::ExEx);
+    BypassPath need = BypassPath::WbId;
+    if (dist == 1) {
+        if (load && !ex_load_early) {
+            // The data exists after MEM: only a STORE's data, needed in MEM, can wait for it
+            if (!store_data) return {true, load_use, -1};
+            if (has(BypassPath::MemMem)) return {false, false, (int)BypassPath::MemMem};
+            return {true, load_use, (int)BypassPath::MemMem};
+        } else if (branch) {
+            return {true, false, -1};       // the comparator works alongside the producer's EX
+        } else {
+            need = (store_data && !has(BypassPath::ExEx) && has(BypassPath::MemMem)) ? BypassPath::MemMem
+                                                                                      : BypassPath::ExEx;
+        }
+    } else if (dist == 2) {
+        if (branch && load && !mem_load_ready) return {true, load_use, -1};
+        need = branch ? BypassPath::ExEx : BypassPath::MemEx;
+    }
+    if (has(need)) return {false, false, (int)need};
+    return {true, false, (int)need};
+}
+
 HazardDecision detect_hazard_for_ID(const Instruction& id_ins, bool id_valid,
                                     const Instruction& ex_ins, bool ex_valid,
                                     const Instruction& mem_ins, bool mem_valid,
                                     const Instruction& wb_ins,  bool wb_valid,
-                                    bool forwarding_on)
+                                    uint8_t bypass_paths,
+                                    bool ex_load_early,
+                                    bool branch_in_id,
+                                    bool mem_load_ready)
 {
     HazardDecision d;
 
     if (!id_valid) return d; // no instruction in ID
 
-    const bool id_reads1 = reads_r1(id_ins);
-    const bool id_reads2 = reads_r2(id_ins);
-    const int r1 = id_ins.rs1;
-    const int r2 = id_ins.rs2;
-
     // --- RAW hazards only (for in-order 5-stage, WAR/WAW don't actually require stalls) ---
-    // With forwarding ON:
-    //   * if EX is a LOAD producing rd and ID uses that rd -> load-use hazard: ONE stall.
-    //   * otherwise, EX/MEM & MEM/WB producers can be forwarded -> no stall.
-    //
-    // With forwarding OFF:
-    //   * any producer in EX/MEM/WB whose rd matches ID.rs1 or ID.rs2 -> stall.
-
-    auto check_raw_match = [&](const Instruction& prod, bool valid) -> bool {
-        if (!valid) return false;
-        int rd = dest_reg(prod);
-        if (rd < 0) return false;
-        return (id_reads1 && r1 == rd) || (id_reads2 && r2 == rd);
+    // Each source operand takes its value from the nearest producer ahead, over
+    // whichever bypass that distance needs (see route_operand). With every
+    // default path a LOAD in EX is the one stall left (load-use); with none,
+    // any producer in EX/MEM/WB stalls until it has written the register file.
+    const Instruction* stages[3] = {ex_valid ? &ex_ins : nullptr, mem_valid ? &mem_ins : nullptr,
+                                    wb_valid ? &wb_ins : nullptr};
+    const struct { bool reads; int reg; bool store_data; } operands[3] = {
+        {reads_r1(id_ins), id_ins.rs1, false},
+        {reads_r2(id_ins), id_ins.rs2, id_ins.op == Opcode::STORE},
+        {fused_src(id_ins) >= 0, fused_src(id_ins), false},
     };
 
-    if (forwarding_on) {
-        // load-use from EX stage
-        if (ex_valid && ex_ins.op == Opcode::LOAD && check_raw_match(ex_ins, true)) {
-            d.stall = true;
-            d.kind = HazardKind::RAW;
-            return d;
-        }
-        // Everything else is forwardable -> no stall.
-        return d;
-    } else {
-        // No forwarding: any pending producer causes a stall
-        if (check_raw_match(ex_ins, ex_valid) ||
-            check_raw_match(mem_ins, mem_valid) ||
-            check_raw_match(wb_ins,  wb_valid)) {
-            d.stall = true;
-            d.kind = HazardKind::RAW;
-            return d;
+    bool only_branch = true;    // every stalled operand would be fine outside the ID comparator
+    bool one_missing = true;    // ... and they all miss the same path
+    OperandRoute routes[3];
+    for (int o = 0; o < 3; ++o) {
+        if (!operands[o].reads) continue;
+        const int r = operands[o].reg;
+        int dist = 0;
+        while (dist < 3 && !(stages[dist] && (dest_reg(*stages[dist]) == r || fused_dest(*stages[dist]) == r)))
+            ++dist;
+        if (dist == 3) continue;     // in the register file
+        OperandRoute rt = route_operand(*stages[dist], dist + 1, bypass_paths, operands[o].store_data,
+                                        false, ex_load_early, mem_load_ready);
+        bool branch_only = false;
+        if (!rt.stall && branch_in_id) {
+            rt = route_operand(*stages[dist], dist + 1, bypass_paths, false, true,
+                               ex_load_early, mem_load_ready);
+            branch_only = rt.stall;
         }
+        routes[o] = rt;
+        if (!rt.stall) continue;
+        if (d.stall && d.missing_bypass != rt.path) one_missing = false;
+        only_branch = only_branch && branch_only;
+        d.stall = true;
+        d.load_use = d.load_use || rt.load_use;
+        d.missing_bypass = rt.path;
+    }
+    if (d.stall) {
+        d.kind = HazardKind::RAW;
+        d.branch_operand = only_branch;
+        if (!one_missing) d.missing_bypass = -1;
         return d;
     }
+    for (const OperandRoute& rt : routes)
+        if (rt.path >= 0) d.bypassed[rt.path]++;
+    return d;
 }
@@ -0,0 +1,103 @@
+#include "host_perf.hpp"
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char* host_counter_name(HostCounter c) {
+    switch (c) {
+        case HostCounter::Cycles:       return "cycles";
+        case HostCounter::Instructions: return "instructions";
+        case HostCounter::BranchMisses: return "branch_misses";
+        case HostCounter::LlcMisses:    return "llc_misses";
+        default:                        return "?";
+    }
+}
+
+static int64_t now_ns() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+#if defined(__linux__)
+static int open_counter(uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // this thread, any CPU, no group
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+HostPerf::HostPerf(bool enabled) {
+    for (int& fd : fd_) fd = -1;
+    if (!enabled) return;
+#if defined(__linux__)
+    static const uint64_t kConfig[kNumHostCounters] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_BRANCH_MISSES,
+        PERF_COUNT_HW_CACHE_MISSES,     // last-level cache misses on most PMUs
+    };
+    for (int c = 0; c < kNumHostCounters; ++c) {
+        fd_[c] = open_counter(kConfig[c]);
+        if (fd_[c] < 0) {
+            if (!error_.empty()) error_ += "; ";
+            error_ += std::string(host_counter_name((HostCounter)c)) + ": " + std::strerror(errno);
+        }
+    }
+#else
+    error_ = "perf_event_open not supported on this platform";
+#endif
+}
+
+HostPerf::~HostPerf() {
+#if defined(__linux__)
+    for (int fd : fd_) if (fd >= 0) close(fd);
+#endif
+}
+
+bool HostPerf::available() const {
+    for (int fd : fd_) if (fd >= 0) return true;
+    return false;
+}
+
+void HostPerf::start(const std::string& phase) {
+    cur_ = HostPhase{};
+    cur_.name = phase;
+#if defined(__linux__)
+    for (int fd : fd_) {
+        if (fd < 0) continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+    t0_ns_ = now_ns();
+}
+
+HostPhase HostPerf::stop() {
+    cur_.seconds = double(now_ns() - t0_ns_) * 1e-9;
+#if defined(__linux__)
+    for (int c = 0; c < kNumHostCounters; ++c) {
+        if (fd_[c] < 0) continue;
+        ioctl(fd_[c], PERF_EVENT_IOC_DISABLE, 0);
+        uint64_t v = 0;
+        if (read(fd_[c], &v, sizeof(v)) == (ssize_t)sizeof(v)) {
+            cur_.value[c] = v;
+            cur_.valid[c] = true;
+        }
+    }
+#endif
+    return cur_;
+}
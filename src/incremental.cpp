@@ -0,0 +1,252 @@
+#include "incremental.hpp"
+#include "pipeline.hpp"
+#include "hash.hpp"
+#include "file_io.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+constexpr char kIndexMagic[8] = {'C', 'P', 'U', 'S', 'I', 'M', 'I', 4};
+constexpr uint64_t kPastEnd = 0x9e3779b97f4a7c15ull;   // hash of a PC beyond the program
+
+// One checkpoint (or the end of the run) as recorded in the index
+struct CheckpointInfo {
+    uint64_t cycle = 0;
+    int32_t max_fetched = -1;       // highest PC fetched up to here
+    int32_t lo = INT_MAX, hi = -1;  // PCs fetched since the previous entry
+    uint64_t prefix_key = 0;        // hash of the program over [0, max_fetched]
+    uint64_t state_hash = 0;
+    Metrics metrics;
+};
+static_assert(std::is_trivially_copyable<CheckpointInfo>::value, "index entries are written raw");
+
+struct CacheIndex {
+    std::string predictor;
+    uint64_t config_hash = 0;               // PipelineConfig::hash()
+    uint64_t max_cycles = 0, every = 0;
+    std::vector<uint64_t> pc_hash;          // per PC, over everything the run fetched
+    std::vector<CheckpointInfo> ckpts;      // ckpts[i].cycle == i * every
+    CheckpointInfo final;
+};
+
+std::string index_path(const std::string& dir) { return dir + "/index.bin"; }
+
+std::string ckpt_path(const std::string& dir, uint64_t key, uint64_t cycle) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "/ckpt_%016llx_%llu.bin",
+                  (unsigned long long)key, (unsigned long long)cycle);
+    return dir + name;
+}
+
+bool load_index(const std::string& dir, CacheIndex& idx) {
+    std::ifstream in(index_path(dir), std::ios::binary);
+    char magic[8];
+    if (!in.read(magic, 8) || !std::equal(magic, magic + 8, kIndexMagic)) return false;
+    std::vector<char> name;
+    return get_vec(in, name) && (idx.predictor.assign(name.begin(), name.end()), true) &&
+           get_raw(in, idx.config_hash) && get_raw(in, idx.max_cycles) && get_raw(in, idx.every) &&
+           get_vec(in, idx.pc_hash) && get_vec(in, idx.ckpts) && get_raw(in, idx.final) &&
+           !idx.ckpts.empty();
+}
+
+void save_index(const std::string& dir, const CacheIndex& idx) {
+    std::ofstream os(index_path(dir), std::ios::binary);
+    os.write(kIndexMagic, 8);
+    put_vec(os, std::vector<char>(idx.predictor.begin(), idx.predictor.end()));
+    put_raw(os, idx.config_hash);
+    put_raw(os, idx.max_cycles);
+    put_raw(os, idx.every);
+    put_vec(os, idx.pc_hash);
+    put_vec(os, idx.ckpts);
+    put_raw(os, idx.final);
+}
+
+void save_checkpoint(const std::string& path, const Pipeline& pipe, const BranchPredictor& bp) {
+    std::ofstream os(path, std::ios::binary);
+    pipe.save_state(os);
+    put_raw(os, bp.total_predictions);
+    put_raw(os, bp.mispredictions);
+    PredictorState st;
+    bp.save_state(st);
+    put_vec(os, st);
+}
+
+bool load_checkpoint(const std::string& path, Pipeline& pipe, BranchPredictor& bp) {
+    std::ifstream in(path, std::ios::binary);
+    PredictorState st;
+    if (!(in && pipe.load_state(in) && get_raw(in, bp.total_predictions) &&
+          get_raw(in, bp.mispredictions) && get_vec(in, st)))
+        return false;
+    bp.load_state(st);
+    return true;
+}
+
+// Deletes the checkpoint files `idx` doesn't list: those of an older index (other
+// config or edits) and those a run wrote before splicing onto the cached index
+void prune_checkpoints(const std::string& dir, const CacheIndex& idx) {
+    std::unordered_set<std::string> keep;
+    for (const CheckpointInfo& c : idx.ckpts) keep.insert(ckpt_path(dir, c.prefix_key, c.cycle));
+    std::vector<std::filesystem::path> stale;
+    std::error_code ec;
+    for (const auto& e : std::filesystem::directory_iterator(dir, ec)) {
+        const std::string name = e.path().filename().string();
+        if (name.rfind("ckpt_", 0) == 0 && !keep.count(dir + "/" + name)) stale.push_back(e.path());
+    }
+    for (const auto& p : stale) std::filesystem::remove(p, ec);
+}
+
+// Per-PC content hashes and their running prefix hashes, extended on demand
+class ProgramHashes {
+public:
+    explicit ProgramHashes(const InstructionSource& prog) : prog_(prog) {}
+
+    uint64_t pc(int p) { extend(p); return hash_[p]; }
+    uint64_t prefix(int p) { if (p < 0) return kHashSeed; extend(p); return prefix_[p]; }
+    std::vector<uint64_t> upto(int p) { extend(p); return std::vector<uint64_t>(hash_.begin(), hash_.begin() + p + 1); }
+
+private:
+    void extend(int p) {
+        while ((int)hash_.size() <= p) {
+            const int i = (int)hash_.size();
+            hash_.push_back(i < prog_.size() ? content_hash(prog_.at(i)) : kPastEnd);
+            prefix_.push_back(hash_mix(i ? prefix_.back() : kHashSeed, hash_.back()));
+        }
+    }
+    const InstructionSource& prog_;
+    std::vector<uint64_t> hash_, prefix_;
+};
+
+} // namespace
+
+std::optional<std::string> run_incremental(const InstructionSource& prog, BranchPredictor& bp,
+                                           const IncrementalConfig& cfg, IncrementalResult& out) {
+    std::error_code ec;
+    std::filesystem::create_directories(cfg.dir, ec);
+    if (ec) return "Cannot create cache directory " + cfg.dir + ": " + ec.message();
+    const uint64_t every = cfg.every ? cfg.every : 1;
+
+    out = IncrementalResult{};
+    CacheIndex old;
+    out.cache_hit = load_index(cfg.dir, old) && old.predictor == cfg.predictor &&
+                    old.config_hash == cfg.pipeline.hash() && old.max_cycles == cfg.max_cycles &&
+                    old.every == every;
+
+    ProgramHashes hashes(prog);
+    Pipeline pipe(prog, cfg.pipeline, &bp);
+
+    // Edited PCs among those the cached run fetched (later PCs can't have influenced it)
+    std::vector<int> edited;
+    if (out.cache_hit) {
+        for (int p = 0; p < (int)old.pc_hash.size(); ++p)
+            if (hashes.pc(p) != old.pc_hash[p]) edited.push_back(p);
+        if (edited.empty()) {
+            out.metrics = old.final.metrics;
+            out.spliced = true;
+            return std::nullopt;
+        }
+        out.first_edit = edited.front();
+    }
+
+    // Resume from the last checkpoint whose prefix key still matches
+    std::vector<CheckpointInfo> ckpts;
+    size_t resumed = 0;
+    if (out.cache_hit) {
+        for (size_t k = old.ckpts.size(); k-- > 0;) {
+            const CheckpointInfo& c = old.ckpts[k];
+            if (c.max_fetched >= out.first_edit || hashes.prefix(c.max_fetched) != c.prefix_key) continue;
+            if (!load_checkpoint(ckpt_path(cfg.dir, c.prefix_key, c.cycle), pipe, bp)) continue;
+            ckpts.assign(old.ckpts.begin(), old.ckpts.begin() + k + 1);
+            resumed = k;
+            out.resumed_at = c.cycle;
+            break;
+        }
+        if (ckpts.empty()) {
+            pipe = Pipeline(prog, cfg.pipeline, &bp);
+            bp.load_state(PredictorState{});
+            bp.total_predictions = bp.mispredictions = 0;
+        }
+    }
+
+    // Cached PC range fetched after each checkpoint, for the reconvergence check
+    std::vector<int> suffix_lo(old.ckpts.size(), INT_MAX), suffix_hi(old.ckpts.size(), -1);
+    if (out.cache_hit) {
+        int lo = old.final.lo, hi = old.final.hi;
+        for (size_t k = old.ckpts.size(); k-- > 0;) {
+            suffix_lo[k] = lo;
+            suffix_hi[k] = hi;
+            lo = std::min(lo, old.ckpts[k].lo);
+            hi = std::max(hi, old.ckpts[k].hi);
+        }
+    }
+    auto touches_edit = [&](int lo, int hi) {
+        auto it = std::lower_bound(edited.begin(), edited.end(), lo);
+        return it != edited.end() && *it <= hi;
+    };
+    // Cached states we could rejoin. An edit usually shifts timing, so the new run
+    // is checked every cycle against all of them, not only at equal cycles. A
+    // run that stopped at the cycle cap can only be rejoined without a shift.
+    std::unordered_map<uint64_t, size_t> rejoin;
+    if (out.cache_hit)
+        for (size_t k = resumed + 1; k < old.ckpts.size(); ++k)
+            if (!touches_edit(suffix_lo[k], suffix_hi[k])) rejoin.emplace(old.ckpts[k].state_hash, k);
+    const bool cached_halted = old.final.cycle < old.max_cycles;
+
+    int max_fetched = ckpts.empty() ? -1 : ckpts.back().max_fetched;
+    auto take = [&]() {
+        CheckpointInfo c;
+        c.cycle = pipe.cycle();
+        pipe.take_fetch_range(c.lo, c.hi);
+        max_fetched = std::max(max_fetched, c.hi);
+        c.max_fetched = max_fetched;
+        c.prefix_key = hashes.prefix(max_fetched);
+        c.state_hash = pipe.state_hash();
+        c.metrics = pipe.metrics();
+        return c;
+    };
+    if (ckpts.empty()) {
+        ckpts.push_back(take());
+        save_checkpoint(ckpt_path(cfg.dir, ckpts.back().prefix_key, 0), pipe, bp);
+    }
+
+    while (!pipe.halted() && pipe.cycle() < cfg.max_cycles) {
+        pipe.step();
+        out.simulated++;
+
+        if (!rejoin.empty()) {
+            auto it = rejoin.find(pipe.state_hash());
+            if (it != rejoin.end() && (cached_halted || old.ckpts[it->second].cycle == pipe.cycle())) {
+                // Same state and the cached run never looks at an edit again: its future is ours
+                out.metrics = pipe.metrics();
+                out.metrics.add_delta(old.final.metrics, old.ckpts[it->second].metrics);
+                out.spliced = true;
+                out.spliced_at = pipe.cycle();
+                prune_checkpoints(cfg.dir, old);   // the cached index stays; drop this run's
+                return std::nullopt;
+            }
+        }
+        if (pipe.cycle() % every) continue;
+        ckpts.push_back(take());
+        save_checkpoint(ckpt_path(cfg.dir, ckpts.back().prefix_key, ckpts.back().cycle), pipe, bp);
+    }
+    out.metrics = pipe.metrics();
+
+    CacheIndex idx;
+    idx.predictor = cfg.predictor;
+    idx.config_hash = cfg.pipeline.hash();
+    idx.max_cycles = cfg.max_cycles;
+    idx.every = every;
+    idx.final = take();
+    idx.pc_hash = hashes.upto(max_fetched);
+    idx.ckpts = std::move(ckpts);
+    save_index(cfg.dir, idx);
+    prune_checkpoints(cfg.dir, idx);
+    return std::nullopt;
+}
@@ -0,0 +1,339 @@
+#include "live_server.hpp"
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#define LIVE_HAVE_SOCKETS 1
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+// ------------------------------ producer side ------------------------------
+
+void LiveServer::publish_row(const TimelineRow& row) {
+    last_cycle_.store(row.cycle, std::memory_order_relaxed);
+
+    // Adapt the sampling stride to ring pressure
+    size_t fill = rows_.size();
+    if (fill > kRowRing / 2 && stride_ < kMaxStride) stride_ *= 2;
+    else if (fill < kRowRing / 8 && stride_ > 1) stride_ /= 2;
+    cur_stride_.store(stride_, std::memory_order_relaxed);
+
+    if (seq_++ % stride_ != 0) { sampled_out_.fetch_add(1, std::memory_order_relaxed); return; }
+    if (!rows_.push(row)) dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void LiveServer::publish_interval(const IntervalSample& iv) {
+    if (!intervals_.push(iv)) dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+#if LIVE_HAVE_SOCKETS
+
+// ------------------------------ SHA-1 / base64 ------------------------------
+// Only needed for the WebSocket handshake (Sec-WebSocket-Accept).
+
+static std::string sha1(const std::string& msg) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    std::string m = msg;
+    uint64_t bits = (uint64_t)msg.size() * 8;
+    m += (char)0x80;
+    while (m.size() % 64 != 56) m += (char)0;
+    for (int i = 7; i >= 0; --i) m += (char)((bits >> (8 * i)) & 0xff);
+
+    auto rol = [](uint32_t v, int n) { return (v << n) | (v >> (32 - n)); };
+    for (size_t off = 0; off < m.size(); off += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            const unsigned char* p = (const unsigned char*)m.data() + off + 4 * i;
+            w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+        }
+        for (int i = 16; i < 80; ++i) w[i] = rol(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20)      { f = (b & c) | (~b & d);          k = 0x5A827999; }
+            else if (i < 40) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+            else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+            else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d; d = c; c = rol(b, 30); b = a; a = t;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+    }
+    std::string out;
+    for (uint32_t v : h)
+        for (int i = 3; i >= 0; --i) out += (char)((v >> (8 * i)) & 0xff);
+    return out;
+}
+
+static std::string base64(const std::string& in) {
+    static const char* tbl = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    size_t i = 0;
+    for (; i + 2 < in.size(); i += 3) {
+        uint32_t v = (uint8_t)in[i] << 16 | (uint8_t)in[i+1] << 8 | (uint8_t)in[i+2];
+        out += tbl[v >> 18]; out += tbl[(v >> 12) & 63]; out += tbl[(v >> 6) & 63]; out += tbl[v & 63];
+    }
+    if (i + 1 == in.size()) {
+        uint32_t v = (uint8_t)in[i] << 16;
+        out += tbl[v >> 18]; out += tbl[(v >> 12) & 63]; out += "==";
+    } else if (i + 2 == in.size()) {
+        uint32_t v = (uint8_t)in[i] << 16 | (uint8_t)in[i+1] << 8;
+        out += tbl[v >> 18]; out += tbl[(v >> 12) & 63]; out += tbl[(v >> 6) & 63]; out += '=';
+    }
+    return out;
+}
+
+// ------------------------------ encoding ------------------------------
+
+template <typename T>
+static void put_le(std::string& out, T v) {
+    for (size_t i = 0; i < sizeof(T); ++i) out += (char)(((uint64_t)v >> (8 * i)) & 0xff);
+}
+
+static void encode_row(std::string& out, const TimelineRow& r) {
+    put_le<uint64_t>(out, r.cycle);
+    for (const TimelineCell& c : r.cell) {
+        put_le<uint8_t>(out, c.kind);
+        put_le<uint8_t>(out, c.code);
+        put_le<int32_t>(out, c.id);
+    }
+}
+
+static void encode_interval(std::string& out, const IntervalSample& iv) {
+    put_le<uint8_t>(out, 2);
+    out.append(7, '\0');
+    put_le<uint64_t>(out, iv.start_cycle);
+    put_le<uint64_t>(out, iv.cycles);
+    put_le<uint64_t>(out, iv.retired);
+    put_le<uint64_t>(out, iv.bp_predictions);
+    put_le<uint64_t>(out, iv.bp_mispredictions);
+    for (uint64_t v : iv.cpi_stack.cycles) put_le<uint64_t>(out, v);
+}
+
+// Wrap a payload into a single unmasked binary WebSocket frame
+static std::string ws_frame(const std::string& payload) {
+    std::string f;
+    f += (char)0x82;
+    if (payload.size() < 126) {
+        f += (char)payload.size();
+    } else if (payload.size() <= 0xffff) {
+        f += (char)126;
+        f += (char)((payload.size() >> 8) & 0xff);
+        f += (char)(payload.size() & 0xff);
+    } else {
+        f += (char)127;
+        for (int i = 7; i >= 0; --i) f += (char)(((uint64_t)payload.size() >> (8 * i)) & 0xff);
+    }
+    return f + payload;
+}
+
+// ------------------------------ server thread ------------------------------
+
+LiveServer::~LiveServer() {
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+    if (listen_fd_ >= 0) close(listen_fd_);
+}
+
+std::string LiveServer::start(int port) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd_ < 0) return std::string("socket: ") + std::strerror(errno);
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(listen_fd_, (sockaddr*)&addr, sizeof(addr)) < 0)
+        return "bind 127.0.0.1:" + std::to_string(port) + ": " + std::strerror(errno);
+    if (listen(listen_fd_, 4) < 0) return std::string("listen: ") + std::strerror(errno);
+
+    running_ = true;
+    thread_ = std::thread(&LiveServer::run, this);
+    return "";
+}
+
+void LiveServer::wait_for_client() const {
+    while (running_ && !client_) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+}
+
+void LiveServer::finish(int drain_ms) {
+    finished_ = true;
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(drain_ms);
+    while (client_ && (rows_.size() > 0 || intervals_.size() > 0 || !finished_sent_) &&
+           std::chrono::steady_clock::now() < until)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    running_ = false;
+    if (thread_.joinable()) thread_.join();
+}
+
+// Read an HTTP request head; returns false on error/timeout
+static bool read_request(int fd, std::string& req) {
+    char buf[1024];
+    while (req.find("\r\n\r\n") == std::string::npos) {
+        pollfd p{fd, POLLIN, 0};
+        if (poll(&p, 1, 2000) <= 0) return false;
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) return false;
+        req.append(buf, (size_t)n);
+        if (req.size() > 16384) return false;
+    }
+    return true;
+}
+
+static std::string header_value(const std::string& req, const std::string& name) {
+    std::string lower = req;
+    for (char& c : lower) c = (char)std::tolower((unsigned char)c);
+    std::string key = "\r\n" + name + ":";
+    size_t p = lower.find(key);
+    if (p == std::string::npos) return "";
+    p += key.size();
+    size_t e = req.find("\r\n", p);
+    std::string v = req.substr(p, e - p);
+    size_t a = v.find_first_not_of(" \t"), b = v.find_last_not_of(" \t");
+    return a == std::string::npos ? "" : v.substr(a, b - a + 1);
+}
+
+static bool send_all_blocking(int fd, const std::string& s) {
+    size_t off = 0;
+    while (off < s.size()) {
+        ssize_t n = send(fd, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        off += (size_t)n;
+    }
+    return true;
+}
+
+void LiveServer::run() {
+    static const char* kGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    static const size_t kRowsPerFrame = 1024;
+    int client = -1;
+    std::string out;      // bytes queued for the client (sent without blocking)
+
+    auto drop_client = [&]() {
+        if (client >= 0) close(client);
+        client = -1;
+        out.clear();
+        client_ = false;
+    };
+
+    while (running_) {
+        // Accept new connections (one WebSocket client at a time)
+        pollfd lp{listen_fd_, POLLIN, 0};
+        if (poll(&lp, 1, client >= 0 ? 0 : 20) > 0) {
+            int fd = accept(listen_fd_, nullptr, nullptr);
+            std::string req;
+            if (fd >= 0 && read_request(fd, req)) {
+                std::string key = header_value(req, "sec-websocket-key");
+                if (!key.empty()) {
+                    std::string resp =
+                        "HTTP/1.1 101 Switching Protocols\r\n"
+                        "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                        "Sec-WebSocket-Accept: " + base64(sha1(key + kGuid)) + "\r\n\r\n";
+                    if (send_all_blocking(fd, resp)) {
+                        drop_client();
+                        client = fd;
+                        client_ = true;
+                        fd = -1;
+                    }
+                } else {
+                    std::string body = "{\"cycle\":" + std::to_string(last_cycle_.load()) +
+                        ",\"stride\":" + std::to_string(cur_stride_.load()) +
+                        ",\"dropped\":" + std::to_string(dropped_.load()) +
+                        ",\"client\":" + (client_ ? "true" : "false") + "}\n";
+                    send_all_blocking(fd,
+                        "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                        "Access-Control-Allow-Origin: *\r\nConnection: close\r\n"
+                        "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body);
+                }
+            }
+            if (fd >= 0) close(fd);
+        }
+
+        // Drain the rings into frames; with no client, rows are simply discarded.
+        // While a previous frame is still queued we stop draining, so pressure
+        // builds up in the ring and the producer switches to sampling.
+        bool idle = true;
+        if (out.empty()) {
+            IntervalSample iv;
+            while (intervals_.pop(iv)) {
+                idle = false;
+                if (client < 0) continue;
+                std::string p;
+                encode_interval(p, iv);
+                out += ws_frame(p);
+            }
+            std::string rows;
+            TimelineRow r;
+            uint16_t n = 0;
+            while (n < kRowsPerFrame && rows_.pop(r)) { encode_row(rows, r); ++n; }
+            if (n) {
+                idle = false;
+                if (client >= 0) {
+                    std::string p;
+                    put_le<uint8_t>(p, 1);
+                    put_le<uint8_t>(p, 0);
+                    put_le<uint16_t>(p, n);
+                    put_le<uint32_t>(p, cur_stride_.load());
+                    out += ws_frame(p + rows);
+                }
+            }
+            if (finished_ && !finished_sent_ && rows_.size() == 0 && intervals_.size() == 0) {
+                if (client >= 0) {
+                    std::string p;
+                    put_le<uint8_t>(p, 3);
+                    p.append(7, '\0');
+                    put_le<uint64_t>(p, dropped_.load());
+                    put_le<uint64_t>(p, sampled_out_.load());
+                    out += ws_frame(p);
+                }
+                finished_sent_ = true;
+            }
+        }
+
+        if (client >= 0) {
+            // Discard anything the client sends; a close frame or EOF ends the session
+            char buf[512];
+            ssize_t n = recv(client, buf, sizeof(buf), MSG_DONTWAIT);
+            if (n == 0 || (n > 0 && (buf[0] & 0x0f) == 0x8)) { drop_client(); continue; }
+
+            if (!out.empty()) {
+                ssize_t w = send(client, out.data(), out.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (w > 0) { out.erase(0, (size_t)w); idle = false; }
+                else if (w < 0 && errno != EAGAIN && errno != EWOULDBLOCK) { drop_client(); continue; }
+            }
+        }
+        if (idle) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    // Shutting down: hand the client what is already framed (bounded wait)
+    if (client >= 0 && !out.empty()) {
+        timeval tv{1, 0};
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        send_all_blocking(client, out);
+    }
+    drop_client();
+}
+
+#else
+
+LiveServer::~LiveServer() = default;
+std::string LiveServer::start(int) { return "live server needs POSIX sockets"; }
+void LiveServer::wait_for_client() const {}
+void LiveServer::finish(int) {}
+void LiveServer::run() {}
+
+#endif
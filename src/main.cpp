@@ -4,66 +4,836 @@
 #include <string>
 #include <filesystem>
 #include <unordered_set>
+#include <cstdint>
+#include <cerrno>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <type_traits>
 #include "trace_loader.hpp"
 #include "pipeline.hpp"
 #include "predictor_factory.hpp"
+#include "intervals.hpp"
+#include "host_perf.hpp"
+#include "report.hpp"
+#include "probes.hpp"
+#include "live_server.hpp"
+#include "run_diff.hpp"
+#include "time_travel.hpp"
+#include "incremental.hpp"
+#include "convergence.hpp"
+#include <memory>
+#include <cstdio>
 
 static void print_usage(const char* argv0) {
     std::cout <<
         "CPU Pipeline Simulator\n"
         "Usage:\n"
-        "  " << argv0 << " --trace <path> [--out <csv>] [--predictor <name>] [--no-forwarding]\n\n"
+        "  " << argv0 << " --trace <path> [--out <csv>] [--predictor <name>] [--no-forwarding]\n"
+        "      [--bypass none|all|<path>,...]   (paths: ex-ex, mem-ex, wb-id, mem-mem; default the first three)\n"
+        "      [--mem-ports split|unified] [--rf-ports <read>:<write>] [--div-cycles <n>]\n"
+        "      (unified: IF and LOAD/STORE share one port; 0 ports = unlimited; DIV holds EX <n> cycles)\n"
+        "      [--branch-resolve ex|id]   (id: BEQ/BNE compared in ID, operands forwarded there)\n"
+        "      [--store-buffer <entries>[:<drain-cycles>]]   (0 entries = no store buffer)\n"
+        "      [--early-loads off|naive|storesets] [--ras <entries>]   (0 entries = no RAS)\n"
+        "      [--indirect none|btb|ittage] [--fusion none|all|<rule>,...]   (rules: cmp-branch, alu-branch, load-op)\n"
+        "      [--uop-cache <entries>[:<ways>]] [--uop-repl lru|fifo|random] [--lsd <entries>]\n"
+        "      [--dcache <lines>[:<ways>[:<miss-cycles>]]] [--wrong-path]\n"
+        "      [--itlb <entries>[:<ways>]] [--dtlb <entries>[:<ways>]] [--l2tlb <entries>[:<ways>[:<cycles>]]]\n"
+        "      [--page-walk <cycles-per-level>[:<levels>]] [--pwc <entries>] [--page-bytes <n>]\n"
+        "      [--noc mesh|ring:<cores>] [--noc-hop <cycles>] [--noc-bw <flits-per-cycle>]\n"
+        "      [--noc-load <requests-per-1000-cycles>] [--noc-links <csv>]   (--noc needs --dcache)\n"
+        "      [--energy <model>] [--clock-ghz <f>]   energy per instruction and average power\n"
+        "      [--timing <model>] [--depth-sweep <max-depth>]   clock period, wall time, optimal depth\n"
+        "      [--max-cycles <n>] [--no-timeline] [--latency]\n"
+        "      [--interval <cycles>] [--cpi-stack <csv>] [--stats <json>] [--host-perf]\n"
+        "      [--probe-dump <csv>]   (needs a build with -DCPU_SIM_PROBES=ON)\n"
+        "      [--serve-live <port> [--live-wait]]\n"
+        "      [--snapshot-every <cycles>] [--snapshot-budget <MB>] [--inspect <cycle>[:<rows>]]\n"
+        "      [--incremental <cache-dir> [--checkpoint-every <cycles>]]   (metrics only)\n"
+        "      [--converge <eps>:<window-cycles>]   stop once CPI / mispredict rate are stable\n"
+        "  " << argv0 << " diff <a.csv> <b.csv> [--out <deltas.csv>] [--top <n>]\n"
+        "      align two timelines of the same trace and report retire-cycle deltas\n\n"
         "Predictors:\n"
         "  static_nt | static_t | 1bit | 2bit | tournament\n\n";
 }
 
-int main(int argc, char** argv) {
+// A command-line number that didn't parse; main prints usage and exits with 1
+struct BadNumber { std::string text; };
+
+// The whole of `s` as a T (unsigned types reject a sign), or throws BadNumber
+template <typename T>
+static T to_num(const std::string& s) {
+    const char* p = s.c_str();
+    char* end = nullptr;
+    errno = 0;
+    T v{};
+    if constexpr (std::is_floating_point<T>::value) {
+        v = (T)std::strtod(p, &end);
+    } else if constexpr (std::is_unsigned<T>::value) {
+        const unsigned long long u = std::strtoull(p, &end, 10);
+        if (s.find('-') != std::string::npos || u > std::numeric_limits<T>::max()) throw BadNumber{s};
+        v = (T)u;
+    } else {
+        const long long x = std::strtoll(p, &end, 10);
+        if (x < std::numeric_limits<T>::min() || x > std::numeric_limits<T>::max()) throw BadNumber{s};
+        v = (T)x;
+    }
+    if (s.empty() || end != p + s.size() || errno == ERANGE) throw BadNumber{s};
+    return v;
+}
+
+// A count, size or cycle number: an int that may not be negative
+static int to_count(const std::string& s) {
+    const int v = to_num<int>(s);
+    if (v < 0) throw BadNumber{s};
+    return v;
+}
+
+// "a[:b[:c]]" -> the given counts in order; missing fields keep their values
+static void parse_int_fields(const std::string& v, std::initializer_list<int*> out) {
+    size_t start = 0;
+    for (int* field : out) {
+        const size_t colon = v.find(':', start);
+        *field = to_count(v.substr(start, colon == std::string::npos ? std::string::npos : colon - start));
+        if (colon == std::string::npos) break;
+        start = colon + 1;
+    }
+}
+
+// How the main run was driven, so a comparison baseline can run the same way
+struct BaselineRun {
+    const InstructionSource& prog;
+    std::string predictor;
+    uint64_t max_cycles = 0;
+    uint64_t retired = 0;           // after --converge: stop at the main run's count (0: no limit)
+    std::string cache_dir;          // --incremental: where the main run caches ("" = not incremental)
+    uint64_t checkpoint_every = 0;
+};
+
+// CPI of the same trace under `cfg` (the main run's config with one knob
+// changed), stopped like the main run. Under --incremental it is cached like the
+// main run, in <cache-dir>/baseline-<name>. 0 if it couldn't run.
+static double run_baseline(const BaselineRun& run, const PipelineConfig& cfg, const std::string& name) {
+    auto bp = make_predictor(run.predictor);
+    if (!run.cache_dir.empty()) {
+        IncrementalResult inc;
+        IncrementalConfig icfg{run.cache_dir + "/baseline-" + name, run.checkpoint_every, run.max_cycles, cfg,
+                               bp->name()};
+        if (auto err = run_incremental(run.prog, *bp, icfg, inc)) {
+            std::cerr << "Baseline " << name << ": " << *err << "\n";
+            return 0.0;
+        }
+        std::cout << "Incremental baseline " << name << ": " << inc.simulated << " cycles simulated\n";
+        return inc.metrics.cpi();
+    }
+    Pipeline base(run.prog, cfg, bp.get());
+    while (!base.halted() && base.cycle() < run.max_cycles && (!run.retired || base.metrics().retired < run.retired))
+        base.step();
+    return base.metrics().cpi();
+}
+
+// Clock period and wall time of the run, then one row per --depth-sweep depth
+static void print_timing_report(std::ostream& os, const TimingModel& t, const PipelineConfig& cfg, const Metrics& m) {
+    const TimingPoint run = time_run(t, cfg, m);
+    os << "Timing: period=" << run.period_ps << " ps (" << pipe_stage_name(run.limit) << ") clock="
+       << 1000.0 / run.period_ps << " GHz time=" << run.seconds * 1e6 << " us TPI=" << run.tpi_ps << " ps\n";
+    const std::vector<TimingPoint> sweep = sweep_depths(t, cfg, m);
+    if (sweep.empty()) return;
+    os << "Depth  period_ps     CPI   TPI_ps  split(if/id/ex/mem/wb)\n";
+    for (const TimingPoint& p : sweep) {
+        os << std::setw(5) << p.depth << std::setw(11) << p.period_ps << std::setw(8) << p.cpi
+           << std::setw(9) << p.tpi_ps << "  ";
+        for (int s = 0; s < kNumPipeStages; ++s) os << (s ? "/" : "") << p.split.pieces[s];
+        os << "\n";
+    }
+    const TimingPoint& best = best_depth(sweep);
+    os << "Best depth: " << best.depth << " (TPI " << best.tpi_ps << " ps, "
+       << (best.tpi_ps > 0 ? run.tpi_ps / best.tpi_ps : 0.0) << "x the " << kNumPipeStages << "-stage pipe)\n";
+}
+
+// p50/p90/p99/max per opcode class: fetch->retire latency, then per-stage residency
+static void print_latency_report(std::ostream& os, const Metrics& m) {
+    auto row = [&](const LatencyHistogram& h) {
+        os << std::setw(6) << h.percentile(0.50) << std::setw(6) << h.percentile(0.90)
+           << std::setw(6) << h.percentile(0.99) << std::setw(8) << h.max();
+    };
+    static const char* kStage[kNumTrackedStages] = {"IF", "ID", "EX", "MEM"};
+
+    os << "Latency (cycles)      count   p50   p90   p99     max\n";
+    for (int c = 0; c < kNumOpClasses; ++c) {
+        const LatencyHistogram& tot = m.latency.total[c];
+        if (tot.count() == 0) continue;
+        os << "  " << std::left << std::setw(18) << op_class_name((OpClass)c) << std::right
+           << std::setw(7) << tot.count();
+        row(tot);
+        os << "\n";
+        for (int s = 0; s < kNumTrackedStages; ++s) {
+            os << "    in " << std::left << std::setw(14) << kStage[s] << std::right << std::setw(7) << "";
+            row(m.latency.stage[c][s]);
+            os << "\n";
+        }
+    }
+}
+
+// One row per interval, one column per CPI-stack component (stacked-bar ready)
+static void write_cpi_stack_csv(std::ostream& os, const std::vector<IntervalSample>& series) {
+    os << "start_cycle,cycles,retired";
+    for (int c = 0; c < kNumCpiComponents; ++c) os << "," << cpi_component_name((CpiComponent)c);
+    os << "\n";
+    for (const auto& iv : series) {
+        os << iv.start_cycle << "," << iv.cycles << "," << iv.retired;
+        for (uint64_t v : iv.cpi_stack.cycles) os << "," << v;
+        os << "\n";
+    }
+}
+
+// One row per directed link: traffic and utilization over `cycles`
+static void write_noc_links_csv(std::ostream& os, const Noc& noc, uint64_t cycles) {
+    os << "link,from,to,packets,busy_cycles,utilization_pct,queue_cycles\n";
+    for (size_t i = 0; i < noc.links().size(); ++i) {
+        const Noc::Link& l = noc.links()[i];
+        os << i << "," << l.from << "," << l.to << "," << l.packets << "," << l.busy_by(cycles) << ","
+           << (cycles ? 100.0 * (double)l.busy_by(cycles) / (double)cycles : 0.0) << "," << l.queue << "\n";
+    }
+}
+
+// `cpu-sim diff A B`: compare two timeline CSVs instruction by instruction
+static int run_diff(int argc, char** argv) {
+    std::vector<std::string> inputs;
+    std::string deltasCsv;
+    size_t top = 10;
+    for (int i = 2; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--out" && i + 1 < argc) { deltasCsv = argv[++i]; }
+        else if (a == "--top" && i + 1 < argc) { top = to_num<size_t>(argv[++i]); }
+        else inputs.push_back(a);
+    }
+    if (inputs.size() != 2) { print_usage(argv[0]); return 1; }
+
+    std::ofstream deltas;
+    if (!deltasCsv.empty()) deltas.open(deltasCsv);
+
+    DiffResult r;
+    if (auto err = diff_runs(inputs[0], inputs[1], r, deltas.is_open() ? &deltas : nullptr)) {
+        std::cerr << *err << "\n";
+        return 1;
+    }
+    std::cout << "A: " << inputs[0] << "\nB: " << inputs[1] << "\n";
+    print_diff_report(std::cout, r, top);
+    if (deltas.is_open()) std::cout << "Per-instruction deltas: " << deltasCsv << "\n";
+    return 0;
+}
+
+int main(int argc, char** argv) try {
+    if (argc > 1 && std::string(argv[1]) == "diff") return run_diff(argc, argv);
+
     std::string tracePath = "traces/sample.trace";
     std::string outCsv = "data/timeline.csv";
-    bool forwarding = true;
+    PipelineConfig pipeCfg;
     std::string predictor_name = "static_nt";
+    uint64_t maxCycles = 2000;
+    bool writeTimeline = true;
+    bool latencyReport = false;
+    uint64_t intervalCycles = 0;
+    std::string cpiStackCsv;
+    std::string statsJson;
+    std::string nocLinksCsv;
+    EnergyModel energyModel;
+    bool energyReport = false;
+    bool clockGiven = false;
+    TimingModel timingModel;
+    bool bypassReport = false;
+    bool hostPerf = false;
+    std::string probeDump;
+    int livePort = 0;
+    bool liveWait = false;
+    uint64_t snapshotEvery = 0;
+    size_t snapshotBudgetMb = 64;
+    uint64_t inspectCycle = 0;
+    int inspectRows = 0;
+    std::string incrementalDir;
+    uint64_t checkpointEvery = 10000;
+    double convergeEps = 0.0;
+    uint64_t convergeWindow = 0;
 
     for (int i = 1; i < argc; ++i) {
         std::string a = argv[i];
         if ((a == "--trace" || a == "-t") && i + 1 < argc) { tracePath = argv[++i]; }
         else if (a == "--out" && i + 1 < argc) { outCsv = argv[++i]; }
-        else if (a == "--no-forwarding") { forwarding = false; }
+        else if (a == "--no-forwarding") { pipeCfg.forwarding = false; }
+        else if (a == "--bypass" && i + 1 < argc) {
+            if (!parse_bypass_paths(argv[++i], pipeCfg.bypass_paths)) {
+                std::cerr << "--bypass expects none, all or a list of ex-ex, mem-ex, wb-id, mem-mem\n";
+                return 1;
+            }
+            bypassReport = true;
+        }
+        else if (a == "--mem-ports" && i + 1 < argc) {
+            std::string v = argv[++i];
+            if (v != "split" && v != "unified") {
+                std::cerr << "--mem-ports expects split or unified\n";
+                return 1;
+            }
+            pipeCfg.unified_memory = v == "unified";
+        }
+        else if (a == "--rf-ports" && i + 1 < argc) {
+            parse_int_fields(argv[++i], {&pipeCfg.rf_read_ports, &pipeCfg.rf_write_ports});
+            if (pipeCfg.rf_read_ports < 0 || pipeCfg.rf_read_ports > ReservationTable::kMaxPorts ||
+                pipeCfg.rf_write_ports < 0 || pipeCfg.rf_write_ports > ReservationTable::kMaxPorts) {
+                std::cerr << "--rf-ports expects 0.." << ReservationTable::kMaxPorts << " read and write ports\n";
+                return 1;
+            }
+        }
+        else if (a == "--div-cycles" && i + 1 < argc) {
+            pipeCfg.div_cycles = to_num<int>(argv[++i]);
+            if (pipeCfg.div_cycles < 1 || pipeCfg.div_cycles > 32) {
+                std::cerr << "--div-cycles expects 1..32\n";
+                return 1;
+            }
+        }
+        else if (a == "--branch-resolve" && i + 1 < argc) {
+            if (!parse_branch_resolve(argv[++i], pipeCfg.branch_resolve)) {
+                std::cerr << "--branch-resolve expects ex or id\n";
+                return 1;
+            }
+        }
+        else if (a == "--early-loads" && i + 1 < argc) {
+            if (!parse_early_loads(argv[++i], pipeCfg.early_loads)) {
+                std::cerr << "--early-loads expects off, naive or storesets\n";
+                return 1;
+            }
+        }
+        else if (a == "--store-buffer" && i + 1 < argc) {
+            std::string v = argv[++i];
+            size_t colon = v.find(':');
+            pipeCfg.store_buffer = to_count(v.substr(0, colon));
+            if (colon != std::string::npos) pipeCfg.sb_drain_cycles = to_count(v.substr(colon + 1));
+        }
+        else if (a == "--ras" && i + 1 < argc) {
+            pipeCfg.ras_depth = to_num<int>(argv[++i]);
+            if (pipeCfg.ras_depth < 0 || pipeCfg.ras_depth > ReturnAddressStack::kMaxDepth) {
+                std::cerr << "--ras expects 0.." << ReturnAddressStack::kMaxDepth << " entries\n";
+                return 1;
+            }
+        }
+        else if (a == "--indirect" && i + 1 < argc) {
+            if (!parse_indirect_mode(argv[++i], pipeCfg.indirect)) {
+                std::cerr << "--indirect expects none, btb or ittage\n";
+                return 1;
+            }
+        }
+        else if (a == "--fusion" && i + 1 < argc) {
+            if (!parse_fusion_rules(argv[++i], pipeCfg.fusion_rules)) {
+                std::cerr << "--fusion expects none, all or a list of cmp-branch, alu-branch, load-op\n";
+                return 1;
+            }
+        }
+        else if (a == "--uop-cache" && i + 1 < argc) {
+            std::string v = argv[++i];
+            size_t colon = v.find(':');
+            pipeCfg.uop_cache = to_num<int>(v.substr(0, colon));
+            if (colon != std::string::npos) pipeCfg.uop_ways = to_num<int>(v.substr(colon + 1));
+            if (pipeCfg.uop_cache < 0 || pipeCfg.uop_cache > UopCache::kMaxEntries ||
+                pipeCfg.uop_ways < 1 || pipeCfg.uop_ways > UopCache::kMaxWays) {
+                std::cerr << "--uop-cache expects 0.." << UopCache::kMaxEntries << " entries and 1.."
+                          << UopCache::kMaxWays << " ways\n";
+                return 1;
+            }
+        }
+        else if (a == "--uop-repl" && i + 1 < argc) {
+            if (!parse_uop_replacement(argv[++i], pipeCfg.uop_repl)) {
+                std::cerr << "--uop-repl expects lru, fifo or random\n";
+                return 1;
+            }
+        }
+        else if (a == "--lsd" && i + 1 < argc) {
+            pipeCfg.lsd_entries = to_num<int>(argv[++i]);
+            if (pipeCfg.lsd_entries < 0 || pipeCfg.lsd_entries > LoopStreamDetector::kMaxEntries) {
+                std::cerr << "--lsd expects 0.." << LoopStreamDetector::kMaxEntries << " entries\n";
+                return 1;
+            }
+        }
+        else if (a == "--dcache" && i + 1 < argc) {
+            parse_int_fields(argv[++i], {&pipeCfg.dcache_lines, &pipeCfg.dcache_ways, &pipeCfg.dcache_miss_cycles});
+            if (pipeCfg.dcache_lines < 0 || pipeCfg.dcache_lines > DataCache::kMaxLines ||
+                pipeCfg.dcache_ways < 1 || pipeCfg.dcache_ways > DataCache::kMaxWays || pipeCfg.dcache_miss_cycles < 0) {
+                std::cerr << "--dcache expects 0.." << DataCache::kMaxLines << " lines, 1.."
+                          << DataCache::kMaxWays << " ways and a miss latency >= 0\n";
+                return 1;
+            }
+        }
+        else if (a == "--wrong-path") { pipeCfg.wrong_path = true; }
+        else if ((a == "--itlb" || a == "--dtlb" || a == "--l2tlb" || a == "--pwc") && i + 1 < argc) {
+            int* entries = a == "--itlb" ? &pipeCfg.itlb_entries : a == "--dtlb" ? &pipeCfg.dtlb_entries
+                         : a == "--l2tlb" ? &pipeCfg.l2tlb_entries : &pipeCfg.pwc_entries;
+            int* ways = a == "--itlb" ? &pipeCfg.itlb_ways : a == "--dtlb" ? &pipeCfg.dtlb_ways : &pipeCfg.l2tlb_ways;
+            if (a == "--pwc") parse_int_fields(argv[++i], {entries});
+            else if (a == "--l2tlb") parse_int_fields(argv[++i], {entries, ways, &pipeCfg.l2tlb_cycles});
+            else parse_int_fields(argv[++i], {entries, ways});
+            if (*entries < 0 || *entries > Tlb::kMaxEntries || *ways < 1 || *ways > Tlb::kMaxWays ||
+                pipeCfg.l2tlb_cycles < 0) {
+                std::cerr << a << " expects 0.." << Tlb::kMaxEntries << " entries and 1.." << Tlb::kMaxWays << " ways\n";
+                return 1;
+            }
+        }
+        else if (a == "--page-walk" && i + 1 < argc) {
+            parse_int_fields(argv[++i], {&pipeCfg.walk_level_cycles, &pipeCfg.walk_levels});
+            if (pipeCfg.walk_level_cycles < 0 || pipeCfg.walk_levels < 1 || pipeCfg.walk_levels > 6) {
+                std::cerr << "--page-walk expects cycles >= 0 per level and 1..6 levels\n";
+                return 1;
+            }
+        }
+        else if (a == "--page-bytes" && i + 1 < argc) {
+            pipeCfg.page_bytes = to_num<int>(argv[++i]);
+            if (pipeCfg.page_bytes < kInstrBytes || (pipeCfg.page_bytes & (pipeCfg.page_bytes - 1))) {
+                std::cerr << "--page-bytes expects a power of two >= " << kInstrBytes << "\n";
+                return 1;
+            }
+        }
+        else if (a == "--noc" && i + 1 < argc) {
+            std::string v = argv[++i];
+            const size_t colon = v.find(':');
+            if (colon != std::string::npos) pipeCfg.noc_cores = to_num<int>(v.substr(colon + 1));
+            if (!parse_noc_topology(v.substr(0, colon), pipeCfg.noc) ||
+                pipeCfg.noc_cores < 2 || pipeCfg.noc_cores > Noc::kMaxCores) {
+                std::cerr << "--noc expects mesh or ring, optionally :2.." << Noc::kMaxCores << " cores\n";
+                return 1;
+            }
+        }
+        else if ((a == "--noc-hop" || a == "--noc-bw" || a == "--noc-load") && i + 1 < argc) {
+            int& v = a == "--noc-hop" ? pipeCfg.noc_hop_cycles : a == "--noc-bw" ? pipeCfg.noc_link_flits
+                   : pipeCfg.noc_load;
+            v = to_num<int>(argv[++i]);
+            if (v < (a == "--noc-load" ? 0 : 1) || v > 1000) {
+                std::cerr << a << (a == "--noc-load" ? " expects 0..1000\n" : " expects 1..1000\n");
+                return 1;
+            }
+        }
+        else if (a == "--noc-links" && i + 1 < argc) { nocLinksCsv = argv[++i]; }
+        else if (a == "--energy" && i + 1 < argc) {
+            if (auto err = load_energy_model(argv[++i], energyModel)) { std::cerr << *err << "\n"; return 1; }
+            energyReport = true;
+        }
+        else if (a == "--timing" && i + 1 < argc) {
+            if (auto err = load_timing_model(argv[++i], timingModel)) { std::cerr << *err << "\n"; return 1; }
+            timingModel.enabled = true;
+        }
+        else if (a == "--depth-sweep" && i + 1 < argc) {
+            timingModel.sweep_depth = to_num<int>(argv[++i]);
+            if (timingModel.sweep_depth < kNumPipeStages || timingModel.sweep_depth > 64) {
+                std::cerr << "--depth-sweep expects a depth of " << kNumPipeStages << "..64\n";
+                return 1;
+            }
+            timingModel.enabled = true;
+        }
+        else if (a == "--clock-ghz" && i + 1 < argc) {
+            energyModel.clock_ghz = to_num<double>(argv[++i]);
+            if (!(energyModel.clock_ghz > 0.0)) { std::cerr << "--clock-ghz expects a positive frequency\n"; return 1; }
+            energyReport = true;
+            clockGiven = true;
+        }
         else if (a == "--predictor" && i + 1 < argc) { predictor_name = argv[++i]; }
+        else if (a == "--max-cycles" && i + 1 < argc) { maxCycles = to_num<uint64_t>(argv[++i]); }
+        else if (a == "--no-timeline") { writeTimeline = false; }
+        else if (a == "--latency") { latencyReport = true; }
+        else if (a == "--interval" && i + 1 < argc) { intervalCycles = to_num<uint64_t>(argv[++i]); }
+        else if (a == "--cpi-stack" && i + 1 < argc) { cpiStackCsv = argv[++i]; }
+        else if (a == "--stats" && i + 1 < argc) { statsJson = argv[++i]; }
+        else if (a == "--host-perf") { hostPerf = true; }
+        else if (a == "--probe-dump" && i + 1 < argc) { probeDump = argv[++i]; }
+        else if (a == "--serve-live" && i + 1 < argc) {
+            livePort = to_count(argv[++i]);
+            if (livePort < 1 || livePort > 65535) {
+                std::cerr << "--serve-live expects a port in 1..65535\n";
+                return 1;
+            }
+        }
+        else if (a == "--live-wait") { liveWait = true; }
+        else if (a == "--snapshot-every" && i + 1 < argc) { snapshotEvery = to_num<uint64_t>(argv[++i]); }
+        else if (a == "--snapshot-budget" && i + 1 < argc) { snapshotBudgetMb = to_num<size_t>(argv[++i]); }
+        else if (a == "--inspect" && i + 1 < argc) {
+            std::string v = argv[++i];
+            size_t colon = v.find(':');
+            inspectCycle = to_num<uint64_t>(v.substr(0, colon));
+            inspectRows = colon == std::string::npos ? 5 : to_count(v.substr(colon + 1));
+        }
+        else if (a == "--incremental" && i + 1 < argc) { incrementalDir = argv[++i]; }
+        else if (a == "--checkpoint-every" && i + 1 < argc) { checkpointEvery = to_num<uint64_t>(argv[++i]); }
+        else if (a == "--converge" && i + 1 < argc) {
+            std::string v = argv[++i];
+            size_t colon = v.find(':');
+            if (colon == std::string::npos) { std::cerr << "--converge expects EPS:WINDOW\n"; return 1; }
+            convergeEps = to_num<double>(v.substr(0, colon));
+            convergeWindow = to_num<uint64_t>(v.substr(colon + 1));
+        }
         else if (a == "--help" || a == "-h") { print_usage(argv[0]); return 0; }
     }
 
-    std::vector<Instruction> prog;
+    if (pipeCfg.noc != NocTopology::None && pipeCfg.dcache_lines == 0) {
+        std::cerr << "--noc carries D-cache misses: give a --dcache too\n";
+        return 1;
+    }
+
+    // Incremental runs resume mid-stream, so there is no complete timeline to write
+    const bool incremental = !incrementalDir.empty();
+    if (timingModel.enabled) {
+        // One clock for the whole report: energy runs at the period the timing model gives
+        if (clockGiven) {
+            std::cerr << "--clock-ghz can't be combined with --timing or --depth-sweep (the timing model sets the clock)\n";
+            return 1;
+        }
+        energyModel.clock_ghz = 1000.0 / clock_period_ps(timingModel, StageSplit{});
+    }
+    if (incremental) {
+        if (livePort > 0 || inspectRows > 0 || snapshotEvery > 0 || convergeWindow > 0) {
+            std::cerr << "--incremental can't be combined with --serve-live, --inspect, snapshots or --converge\n";
+            return 1;
+        }
+        writeTimeline = false;
+    }
+
+    probe_install_crash_handler();
+
+    // Host counters around load / simulate / baseline / output (wall time only without --host-perf)
+    HostPerf perf(hostPerf);
+    HostReport host;
+    host.requested = hostPerf;
+    host.available = perf.available();
+    host.error = perf.error();
+    if (hostPerf && !host.available)
+        std::cerr << "Host perf counters unavailable (" << host.error << "); reporting wall time only\n";
+
+    perf.start("load");
+    TraceProgram prog;
     if (auto err = load_trace(tracePath, prog)) { std::cerr << *err << "\n"; return 1; }
+    host.phases.push_back(perf.stop());
     std::cout << "Loaded " << prog.size() << " instructions\n";
 
     std::filesystem::path outPath(outCsv);
-    if (outPath.has_parent_path()) std::filesystem::create_directories(outPath.parent_path());
+    if (writeTimeline && outPath.has_parent_path()) std::filesystem::create_directories(outPath.parent_path());
 
     auto predictor = make_predictor(predictor_name);
 
-    Pipeline pipe(prog, forwarding, predictor.get());
+    Pipeline pipe(prog, pipeCfg, predictor.get());
 
-    std::ofstream fout(outCsv);
-    fout << "cycle,IF,ID,EX,MEM,WB\n";
+    std::ofstream fout;
+    if (writeTimeline) {
+        fout.open(outCsv);
+        fout << "cycle,IF,ID,EX,MEM,WB\n";
+    }
 
-    const int kMaxCycles = 2000;
-    while (!pipe.halted() && pipe.cycle() < kMaxCycles) {
+    // Live streaming to the UI (the server thread never holds up the loop below)
+    std::unique_ptr<LiveServer> live;
+    if (livePort > 0) {
+        live = std::make_unique<LiveServer>();
+        std::string err = live->start(livePort);
+        if (!err.empty()) { std::cerr << "--serve-live: " << err << "\n"; return 1; }
+        std::cout << "Live timeline on ws://127.0.0.1:" << livePort << "\n";
+        if (liveWait) {
+            std::cout << "Waiting for a client...\n";
+            live->wait_for_client();
+        }
+        if (intervalCycles == 0) intervalCycles = 1000;
+    }
+
+    // Snapshots for rewinding (--inspect walks back through them after the run)
+    std::unique_ptr<TimeTravel> timeTravel;
+    if (snapshotEvery == 0 && inspectRows > 0) snapshotEvery = 10000;
+    if (snapshotEvery > 0) {
+        timeTravel = std::make_unique<TimeTravel>(pipe, predictor.get(), snapshotEvery,
+                                                  snapshotBudgetMb << 20);
+        timeTravel->record();
+    }
+
+    std::unique_ptr<ConvergenceMonitor> converge;
+    if (convergeWindow > 0) converge = std::make_unique<ConvergenceMonitor>(convergeEps, convergeWindow);
+
+    IntervalRecorder intervals(intervalCycles);
+    size_t intervalsSent = 0;
+    TimelineRow liveRow;
+    Metrics incMetrics;
+    perf.start("simulate");
+    if (incremental) {
+        IncrementalResult inc;
+        IncrementalConfig cfg{incrementalDir, checkpointEvery, maxCycles, pipeCfg, predictor->name()};
+        if (auto err = run_incremental(prog, *predictor, cfg, inc)) { std::cerr << *err << "\n"; return 1; }
+        std::cout << "Incremental: ";
+        if (!inc.cache_hit) std::cout << "no usable cache, full run";
+        else if (inc.first_edit < 0) std::cout << "no edits in fetched code, cached result reused";
+        else std::cout << "first edit at PC " << inc.first_edit << ", resumed at cycle " << inc.resumed_at;
+        if (inc.cache_hit && inc.first_edit >= 0 && inc.spliced)
+            std::cout << ", reconverged at cycle " << inc.spliced_at;
+        std::cout << " (" << inc.simulated << " cycles simulated)\n";
+        incMetrics = inc.metrics;
+    }
+    while (!incremental && !pipe.halted() && pipe.cycle() < maxCycles) {
         pipe.step();
-        fout << pipe.csv_row() << "\n";
+        if (writeTimeline) fout << pipe.csv_row() << "\n";
+        intervals.sample(pipe.metrics());
+        if (timeTravel) timeTravel->record();
+        if (live) {
+            pipe.timeline_row(liveRow);
+            live->publish_row(liveRow);
+            while (intervalsSent < intervals.samples().size())
+                live->publish_interval(intervals.samples()[intervalsSent++]);
+        }
+        if (converge && converge->sample(pipe.metrics())) break;
+    }
+    intervals.finish(pipe.metrics());
+    if (live) {
+        while (intervalsSent < intervals.samples().size())
+            live->publish_interval(intervals.samples()[intervalsSent++]);
+        live->finish();
+        std::cout << "Live stream: sampled out " << live->sampled_out_rows()
+                  << " rows, dropped " << live->dropped_rows() << "\n";
     }
+    if (writeTimeline) fout.close();
+    host.phases.push_back(perf.stop());
 
-    const Metrics& m = pipe.metrics();
+    Metrics m = incremental ? incMetrics : pipe.metrics();
+    if (converge) m.convergence = converge->result();
+    if (pipeCfg.fusion_rules || pipeCfg.branch_resolve == BranchResolve::Id) {
+        perf.start("baseline");
+        const BaselineRun run{prog, predictor_name, maxCycles, converge ? m.retired : 0,
+                              incrementalDir, checkpointEvery};
+        if (pipeCfg.fusion_rules) {   // for the CPI gain
+            PipelineConfig cfg = pipeCfg;
+            cfg.fusion_rules = 0;
+            m.fusion.baseline_cpi = run_baseline(run, cfg, "unfused");
+        }
+        if (pipeCfg.branch_resolve == BranchResolve::Id) {   // for the trade-off
+            PipelineConfig cfg = pipeCfg;
+            cfg.branch_resolve = BranchResolve::Ex;
+            m.branch_resolve.ex_baseline_cpi = run_baseline(run, cfg, "ex-resolve");
+        }
+        host.phases.push_back(perf.stop());
+    }
+    perf.start("output");
     std::cout << "Done. Cycles=" << m.cycles
               << " Retired=" << m.retired
               << " CPI=" << m.cpi()
               << " StallsRAW=" << m.stalls.raw
               << " StallsCTRL=" << m.stalls.control
               << " TotalStalls=" << m.stalls.total()
-              << " Forwarding=" << (forwarding ? "ON" : "OFF")
+              << " Forwarding=" << (pipeCfg.forwarding ? "ON" : "OFF")
               << " Predictor=" << predictor->name()
               << " BP_Acc=" << m.bp_accuracy_pct() << "% "
               << "(Pred=" << m.bp_predictions
               << ", Mispred=" << m.bp_mispredictions << ")\n";
-    std::cout << "Timeline CSV: " << outCsv << "\n";
+    std::cout << "CPI stack (cycles):";
+    for (int c = 0; c < kNumCpiComponents; ++c)
+        std::cout << " " << cpi_component_name((CpiComponent)c) << "=" << m.cpi_stack.cycles[c];
+    std::cout << "\n";
+    if (pipeCfg.store_buffer > 0)
+        std::cout << "Store buffer: loads=" << m.mem.loads << " stores=" << m.mem.stores
+                  << " forwarded=" << m.mem.stlf_forwards << " StallsSBFull=" << m.stalls.sb_full
+                  << " StallsPartial=" << m.stalls.stlf_partial << "\n";
+    if (pipeCfg.early_loads != EarlyLoads::Off)
+        std::cout << "Early loads (" << early_loads_name(pipeCfg.early_loads) << "): early="
+                  << m.mem.early_loads << " held=" << m.mem.held_loads
+                  << " false_deps=" << m.mem.false_dependences
+                  << " violations=" << m.mem.order_violations
+                  << " replay_cycles=" << m.mem.replay_bubbles << "\n";
+    if (m.calls.calls || m.calls.returns)
+        std::cout << "Calls: calls=" << m.calls.calls << " returns=" << m.calls.returns
+                  << " RAS=" << pipeCfg.ras_depth << " overflows=" << m.calls.ras_overflows
+                  << " underflows=" << m.calls.ras_underflows
+                  << " ret_mispred=" << m.calls.return_mispredicts << "\n";
+    if (pipeCfg.fusion_rules) {
+        std::cout << "Fusion (" << fusion_rules_string(pipeCfg.fusion_rules) << "): pairs=" << m.fusion.pairs;
+        for (int r = 0; r < kNumFusionRules; ++r)
+            std::cout << " " << fusion_rule_name((FusionRule)r) << "=" << m.fusion.by_rule[r];
+        std::cout << " rate=" << m.fusion_rate_pct() << "% CPI=" << m.cpi()
+                  << " vs " << m.fusion.baseline_cpi << " unfused (gain "
+                  << (m.fusion.baseline_cpi > 0 ? 100.0 * (1.0 - m.cpi() / m.fusion.baseline_cpi) : 0.0)
+                  << "%)\n";
+    }
+    if (bypassReport) {
+        const uint8_t paths = pipeCfg.forwarding ? pipeCfg.bypass_paths : 0;
+        std::cout << "Bypass (" << bypass_paths_string(paths) << "):";
+        for (int p = 0; p < kNumBypassPaths; ++p)
+            std::cout << " " << bypass_path_name((BypassPath)p) << "="
+                      << ((paths >> p) & 1 ? "used:" + std::to_string(m.bypass.used[p])
+                                           : "off,stalls:" + std::to_string(m.bypass.missing[p]));
+        std::cout << " StallsRAW=" << m.stalls.raw << "\n";
+    }
+    if (pipeCfg.unified_memory || pipeCfg.rf_read_ports || pipeCfg.rf_write_ports || m.resources.divides) {
+        const ResourceStats& r = m.resources;
+        std::cout << "Structural (" << (pipeCfg.unified_memory ? "unified" : "split") << " memory, rf "
+                  << pipeCfg.rf_read_ports << "R/" << pipeCfg.rf_write_ports << "W, div "
+                  << pipeCfg.div_cycles << "c): stalls=" << m.stalls.structural << " mem_port=" << r.mem_port
+                  << " rf_read=" << r.rf_read << " rf_write=" << r.rf_write << " divider=" << r.divider
+                  << " divides=" << r.divides << "\n";
+    }
+    if (pipeCfg.branch_resolve == BranchResolve::Id) {
+        const BranchResolveStats& b = m.branch_resolve;
+        const double base = b.ex_baseline_cpi;
+        std::cout << "Branch resolution (id): resolved_in_id=" << b.id_resolved << " operand_stalls="
+                  << b.operand_stalls << " CPI=" << m.cpi() << " vs " << base << " resolving in EX (gain "
+                  << (base > 0 ? 100.0 * (1.0 - m.cpi() / base) : 0.0) << "%)\n";
+    }
+    if (pipeCfg.dcache_lines)
+        std::cout << "D-cache (" << pipeCfg.dcache_lines << " lines x" << pipeCfg.dcache_ways << ", "
+                  << pipeCfg.dcache_miss_cycles << "-cycle miss): accesses=" << m.mem.dcache_accesses
+                  << " misses=" << m.mem.dcache_misses << " StallsMiss=" << m.stalls.dcache_miss << "\n";
+    if (pipeCfg.itlb_entries || pipeCfg.dtlb_entries) {
+        const TlbStats& t = m.tlb;
+        std::cout << "TLB (" << pipeCfg.page_bytes << "-byte pages): iTLB " << t.itlb_misses << "/" << t.itlb_accesses
+                  << " (" << m.itlb_mpki() << " MPKI) dTLB " << t.dtlb_misses << "/" << t.dtlb_accesses
+                  << " (" << m.dtlb_mpki() << " MPKI)";
+        if (pipeCfg.l2tlb_entries)
+            std::cout << " L2 " << t.l2_misses << "/" << t.l2_accesses << " (" << m.l2tlb_mpki() << " MPKI)";
+        std::cout << " walks=" << t.walks << " refs=" << t.walk_refs;
+        if (pipeCfg.pwc_entries) std::cout << " pwc_hits=" << t.pwc_hits;
+        std::cout << " cycles=" << t.cycles << " StallsITLB=" << m.stalls.itlb_miss
+                  << " StallsDTLB=" << m.stalls.dtlb_miss << "\n";
+    }
+    if (pipeCfg.noc != NocTopology::None) {
+        const NocStats& n = m.noc;
+        const Noc& noc = pipe.noc();
+        std::cout << "NoC (" << noc_topology_name(pipeCfg.noc) << " " << noc.rows() << "x" << noc.cols()
+                  << ", " << pipeCfg.noc_hop_cycles << "-cycle hops, " << pipeCfg.noc_link_flits
+                  << " flit/cycle links, load " << pipeCfg.noc_load << "/kcycle per core): requests="
+                  << n.requests << " avg_round_trip=" << n.avg_request_cycles() << " packets=" << n.packets
+                  << " avg_latency=" << n.avg_packet_cycles() << " avg_queue=" << n.avg_queue_cycles()
+                  << " avg_hops=" << n.avg_hops();
+        // Per-link counters live in the pipeline, which an incremental run did not drive throughout
+        if (!incremental && !noc.links().empty() && m.cycles) {
+            size_t hot = 0;
+            uint64_t busy = 0;
+            for (size_t i = 0; i < noc.links().size(); ++i) {
+                busy += noc.links()[i].busy_by(m.cycles);
+                if (noc.links()[i].busy_by(m.cycles) > noc.links()[hot].busy_by(m.cycles)) hot = i;
+            }
+            const Noc::Link& h = noc.links()[hot];
+            std::cout << " link_util avg=" << 100.0 * (double)busy / (double)noc.links().size() / (double)m.cycles
+                      << "% max=" << 100.0 * (double)h.busy_by(m.cycles) / (double)m.cycles << "% ("
+                      << h.from << "->" << h.to << ")";
+        }
+        std::cout << "\n";
+    }
+    if (pipeCfg.wrong_path)
+        std::cout << "Wrong path: instructions=" << m.wrong_path.instructions << " loads=" << m.wrong_path.loads
+                  << " fills=" << m.wrong_path.fills << " prefetch_hits=" << m.wrong_path.prefetch_hits
+                  << " pollution_misses=" << m.wrong_path.pollution_misses << "\n";
+    if (pipeCfg.uop_cache || pipeCfg.lsd_entries) {
+        const FrontendStats& f = m.frontend;
+        std::cout << "Front end: fetched=" << f.fetches << " decoded=" << f.decodes;
+        if (pipeCfg.uop_cache)
+            std::cout << " uop_cache(" << pipeCfg.uop_cache << "x" << pipeCfg.uop_ways << ","
+                      << uop_replacement_name(pipeCfg.uop_repl) << ") hits=" << f.uop_hits
+                      << " misses=" << f.uop_misses << " evictions=" << f.uop_evictions;
+        if (pipeCfg.lsd_entries)
+            std::cout << " lsd(" << pipeCfg.lsd_entries << ") hits=" << f.lsd_hits << " locks=" << f.lsd_locks;
+        std::cout << " hit_rate=" << f.hit_rate_pct() << "% short_redirects=" << f.short_redirects
+                  << " energy=" << f.energy_pct() << "% decode_duty=" << m.decode_duty_pct() << "%\n";
+    }
+    if (m.target_predictions)
+        std::cout << "Indirect jumps (" << indirect_mode_name(pipeCfg.indirect) << "): predictions="
+                  << m.target_predictions << " target_mispred=" << m.target_mispredictions
+                  << " accuracy=" << m.target_accuracy_pct() << "%\n";
+    if (converge) {
+        const ConvergenceStats& c = m.convergence;
+        if (c.converged) std::cout << "Converged at cycle " << c.at_cycle;
+        else             std::cout << "Not converged";
+        std::cout << " (" << c.batches << " batches of " << c.batch_cycles << " cycles)";
+        if (c.batches >= 2 * ConvergenceMonitor::kBatches)
+            std::cout << ": CPI " << c.cpi_mean << " +/- " << c.cpi_halfwidth << ", mispredict rate "
+                      << c.mispredict_rate << " +/- " << c.mispredict_halfwidth << " (95%)";
+        std::cout << "\n";
+    }
+    if (energyReport) {
+        const EnergyReport e = estimate_energy(energyModel, m);
+        std::cout << "Energy (" << energyModel.clock_ghz << " GHz): total=" << e.total_pj / 1000.0
+                  << " nJ EPI=" << e.epi_pj << " pJ power=" << e.power_mw << " mW time="
+                  << e.seconds * 1e6 << " us (";
+        bool first = true;
+        for (int ev = 0; ev < kNumEnergyEvents; ++ev) {
+            if (e.pj[ev] <= 0.0) continue;
+            std::cout << (first ? "" : " ") << energy_event_name((EnergyEvent)ev) << "="
+                      << (e.total_pj > 0.0 ? 100.0 * e.pj[ev] / e.total_pj : 0.0) << "%";
+            first = false;
+        }
+        std::cout << ")\n";
+    }
+    if (timingModel.enabled) print_timing_report(std::cout, timingModel, pipeCfg, m);
+    if (latencyReport) print_latency_report(std::cout, m);
+    const RunInfo run{tracePath, predictor->name(), pipeCfg, maxCycles, intervalCycles, energyModel, timingModel};
+    if (writeTimeline) {
+        std::cout << "Timeline CSV: " << outCsv << "\n";
+        // Summary sidecars: viewers read these instead of rescanning the timeline
+        std::ofstream sj(summary_path(outCsv, ".json"));
+        write_summary_json(sj, run, m, *predictor, intervals.samples());
+        std::ofstream sb(summary_path(outCsv, ".bin"), std::ios::binary);
+        write_summary_bin(sb, run, m, *predictor, intervals.samples());
+        std::cout << "Summary: " << summary_path(outCsv, ".json") << "\n";
+    }
+    if (!cpiStackCsv.empty()) {
+        std::ofstream cs(cpiStackCsv);
+        write_cpi_stack_csv(cs, intervals.samples());
+        std::cout << "CPI stack CSV: " << cpiStackCsv << "\n";
+    }
+    if (!nocLinksCsv.empty()) {
+        if (incremental || pipeCfg.noc == NocTopology::None) {
+            std::cerr << "--noc-links ignored: needs --noc and a non-incremental run\n";
+        } else {
+            std::ofstream ls(nocLinksCsv);
+            write_noc_links_csv(ls, pipe.noc(), m.cycles);
+            std::cout << "NoC links CSV: " << nocLinksCsv << "\n";
+        }
+    }
+    if (!probeDump.empty()) {
+#if CPU_SIM_PROBES
+        if (std::FILE* f = std::fopen(probeDump.c_str(), "w")) {
+            probe_dump(f);
+            std::fclose(f);
+            std::cout << "Probe ring: " << probeDump << "\n";
+        }
+#else
+        std::cerr << "--probe-dump ignored: built without CPU_SIM_PROBES\n";
+#endif
+    }
+    host.phases.push_back(perf.stop());
+
+    if (hostPerf) {
+        for (const HostPhase& p : host.phases) {
+            std::cout << "Host " << p.name << ": " << p.seconds << " s";
+            for (int c = 0; c < kNumHostCounters; ++c)
+                if (p.valid[c]) std::cout << " " << host_counter_name((HostCounter)c) << "=" << p.value[c];
+            std::cout << "\n";
+        }
+    }
+    if (!statsJson.empty()) {
+        std::ofstream js(statsJson);
+        write_stats_json(js, run, m, host);
+        std::cout << "Stats JSON: " << statsJson << "\n";
+    }
+    if (timeTravel) {
+        std::cout << "Snapshots: " << timeTravel->snapshots() << " every " << timeTravel->every()
+                  << " cycles, " << (timeTravel->bytes() >> 10) << " KiB\n";
+    }
+    if (timeTravel && inspectRows > 0) {
+        // Rewind to the cycle, then step back to collect the rows leading up to it
+        std::vector<std::string> rows;
+        const uint64_t runCycles = pipe.cycle();
+        if (timeTravel->seek(inspectCycle)) {
+            do rows.push_back(pipe.csv_row());
+            while ((int)rows.size() < inspectRows && timeTravel->step_back() && pipe.cycle() > 0);
+        }
+        if (rows.empty()) {
+            if (inspectCycle > runCycles)
+                std::cerr << "--inspect: cycle " << inspectCycle << " is past the end of the run\n";
+            else
+                std::cerr << "--inspect: the snapshot before cycle " << inspectCycle << " could not be restored\n";
+            return 1;
+        }
+        std::cout << "cycle,IF,ID,EX,MEM,WB\n";
+        for (auto r = rows.rbegin(); r != rows.rend(); ++r) std::cout << *r << "\n";
+    }
     return 0;
+} catch (const BadNumber& e) {
+    std::cerr << "Invalid number: '" << e.text << "'\n";
+    print_usage(argv[0]);
+    return 1;
 }
@@ -0,0 +1,190 @@
+#include "noc.hpp"
+#include "file_io.hpp"
+#include <algorithm>
+#include <cmath>
+
+Noc::Noc(NocTopology topo, int cores, int hop_cycles, int link_flits, int load_per_kcycle,
+         int slice_cycles, int line_bytes)
+: topo_(topo), cores_(std::clamp(cores, 1, kMaxCores)), hop_cycles_(std::max(hop_cycles, 1)),
+  link_flits_(std::max(link_flits, 1)), load_(std::clamp(load_per_kcycle, 0, 1000)),
+  slice_cycles_(std::max(slice_cycles, 0)), line_flits_(1 + (line_bytes + kFlitBytes - 1) / kFlitBytes) {
+    if (!enabled()) return;
+
+    // Mesh: the squarest rows x cols factorization (a prime count degenerates to a line)
+    rows_ = 1;
+    if (topo_ == NocTopology::Mesh)
+        for (int r = 1; r * r <= cores_; ++r)
+            if (cores_ % r == 0) rows_ = r;
+    cols_ = cores_ / rows_;
+
+    link_of_.assign((size_t)cores_ * cores_, -1);
+    auto connect = [&](int a, int b) {
+        if (a == b || link_of_[(size_t)a * cores_ + b] >= 0) return;
+        link_of_[(size_t)a * cores_ + b] = (int)links_.size();
+        Link l;
+        l.from = (int16_t)a;
+        l.to = (int16_t)b;
+        links_.push_back(l);
+    };
+    for (int t = 0; t < cores_; ++t) {
+        if (topo_ == NocTopology::Ring) {
+            connect(t, (t + 1) % cores_);
+            connect(t, (t + cores_ - 1) % cores_);
+            continue;
+        }
+        const int r = t / cols_, c = t % cols_;
+        if (c + 1 < cols_) connect(t, t + 1);
+        if (c > 0)         connect(t, t - 1);
+        if (r + 1 < rows_) connect(t, t + cols_);
+        if (r > 0)         connect(t, t - cols_);
+    }
+
+    // The other cores' first requests
+    if (load_ > 0)
+        for (int core = 1; core < cores_; ++core) schedule(next_gap(), (uint32_t)core, EventKind::Inject);
+}
+
+int Noc::next_tile(int at, int dst) const {
+    if (topo_ == NocTopology::Ring) {
+        const int fwd = (dst - at + cores_) % cores_;
+        return fwd <= cores_ / 2 ? (at + 1) % cores_ : (at + cores_ - 1) % cores_;
+    }
+    // XY: finish the column first, then the row
+    const int ac = at % cols_, dc = dst % cols_;
+    if (ac != dc) return ac < dc ? at + 1 : at - 1;
+    return at < dst ? at + cols_ : at - cols_;
+}
+
+int Noc::link_index(int from, int to) const { return link_of_[(size_t)from * cores_ + to]; }
+
+void Noc::schedule(uint64_t time, uint32_t what, EventKind kind) {
+    events_.push_back(Event{time, seq_++, what, kind});
+    std::push_heap(events_.begin(), events_.end(), [](const Event& a, const Event& b) {
+        return a.time != b.time ? a.time > b.time : a.seq > b.seq;
+    });
+}
+
+uint32_t Noc::new_packet(int src, int dst, bool response, bool tracked, uint64_t now) {
+    uint32_t idx;
+    if (!free_packets_.empty()) {
+        idx = free_packets_.back();
+        free_packets_.pop_back();
+    } else {
+        idx = (uint32_t)packets_.size();
+        packets_.emplace_back();
+    }
+    Packet& p = packets_[idx];
+    p.src = (int16_t)src;
+    p.dst = (int16_t)dst;
+    p.at = (int16_t)src;
+    p.flits = (uint16_t)(response ? line_flits_ : 1);
+    p.injected = now;
+    p.queued = 0;
+    p.response = response;
+    p.tracked = tracked;
+    p.live = true;
+    schedule(now, idx, EventKind::Hop);
+    return idx;
+}
+
+void Noc::deliver(Packet& p, uint32_t idx, uint64_t t) {
+    stats_.packets++;
+    stats_.packet_cycles += t - p.injected;
+    stats_.queue_cycles += p.queued;
+    if (!p.response) {
+        // Home slice reads the line, then sends it back
+        const int src = p.dst, dst = p.src;
+        const bool tracked = p.tracked;
+        p.live = false;
+        free_packets_.push_back(idx);
+        new_packet(src, dst, true, tracked, t + (uint64_t)slice_cycles_);
+        return;
+    }
+    if (p.tracked) tracked_done_ = t;
+    p.live = false;
+    free_packets_.push_back(idx);
+}
+
+void Noc::run_one() {
+    std::pop_heap(events_.begin(), events_.end(), [](const Event& a, const Event& b) {
+        return a.time != b.time ? a.time > b.time : a.seq > b.seq;
+    });
+    const Event e = events_.back();
+    events_.pop_back();
+    now_ = e.time;
+
+    if (e.kind == EventKind::Inject) {
+        new_packet((int)e.what, (int)(rand64() % (uint64_t)cores_), false, false, e.time);
+        schedule(e.time + next_gap(), e.what, EventKind::Inject);
+        return;
+    }
+    Packet& p = packets_[e.what];
+    if (p.at == p.dst) { deliver(p, e.what, e.time); return; }
+
+    const int next = next_tile(p.at, p.dst);
+    Link& l = links_[(size_t)link_index(p.at, next)];
+    const uint64_t start = std::max(e.time, l.free_at);
+    const uint64_t ser = (uint64_t)((p.flits + link_flits_ - 1) / link_flits_);
+    l.free_at = start + ser;
+    l.busy += ser;
+    l.packets++;
+    l.queue += start - e.time;
+    p.queued += start - e.time;
+    stats_.hops++;
+    p.at = (int16_t)next;
+    // Head flit after hop_cycles, tail flit ser - 1 cycles behind it
+    schedule(start + (uint64_t)hop_cycles_ + ser - 1, e.what, EventKind::Hop);
+}
+
+void Noc::advance(uint64_t t) {
+    while (!events_.empty() && events_.front().time <= t) run_one();
+    now_ = std::max(now_, t);
+}
+
+int Noc::fetch_line(int64_t line, uint64_t now, bool wait) {
+    advance(now);
+    const int home = (int)((uint64_t)line % (uint64_t)cores_);
+    if (!wait) {
+        new_packet(0, home, false, false, now_);
+        return 0;
+    }
+    tracked_done_ = kPending;
+    new_packet(0, home, false, true, now_);
+    while (tracked_done_ == kPending && !events_.empty()) run_one();
+    return (int)(tracked_done_ - now);
+}
+
+uint64_t Noc::rand64() {
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 7;
+    rng_ ^= rng_ << 17;
+    return rng_;
+}
+
+uint64_t Noc::next_gap() {
+    // Geometric inter-arrival: a request each cycle with probability load / 1000
+    if (load_ >= 1000) return 1;
+    const double u = ((rand64() >> 11) + 1) * (1.0 / 9007199254740993.0);   // (0, 1)
+    return 1 + (uint64_t)(std::log(u) / std::log(1.0 - load_ / 1000.0));
+}
+
+// Topology and parameters come from the config; only the dynamic state is stored
+void Noc::save(std::ostream& os) const {
+    put_vec(os, links_);
+    put_vec(os, events_);
+    put_vec(os, packets_);
+    put_vec(os, free_packets_);
+    put_raw(os, seq_);
+    put_raw(os, now_);
+    put_raw(os, rng_);
+    put_raw(os, tracked_done_);
+    put_raw(os, stats_);
+}
+
+bool Noc::load(std::istream& is) {
+    const size_t nlinks = links_.size();
+    return get_vec(is, links_) && links_.size() == nlinks &&
+           get_vec(is, events_) && get_vec(is, packets_) && get_vec(is, free_packets_) &&
+           get_raw(is, seq_) && get_raw(is, now_) && get_raw(is, rng_) &&
+           get_raw(is, tracked_done_) && get_raw(is, stats_);
+}
@@ -1,125 +1,650 @@
 #include "pipeline.hpp"
 #include "trace_loader.hpp"
+#include "probes.hpp"
+#include "hash.hpp"
+#include "file_io.hpp"
+#include <algorithm>
 #include <sstream>
+#include <type_traits>
 
-Pipeline::Pipeline(const std::vector<Instruction>& program,
-                   bool forwarding_on,
+const char* early_loads_name(EarlyLoads e) {
+    switch (e) {
+        case EarlyLoads::Off:       return "off";
+        case EarlyLoads::Naive:     return "naive";
+        case EarlyLoads::StoreSets: return "storesets";
+    }
+    return "?";
+}
+
+bool parse_early_loads(const std::string& s, EarlyLoads& out) {
+    for (EarlyLoads e : {EarlyLoads::Off, EarlyLoads::Naive, EarlyLoads::StoreSets})
+        if (s == early_loads_name(e)) { out = e; return true; }
+    return false;
+}
+
+const char* branch_resolve_name(BranchResolve b) {
+    switch (b) {
+        case BranchResolve::Ex: return "ex";
+        case BranchResolve::Id: return "id";
+    }
+    return "?";
+}
+
+bool parse_branch_resolve(const std::string& s, BranchResolve& out) {
+    for (BranchResolve b : {BranchResolve::Ex, BranchResolve::Id})
+        if (s == branch_resolve_name(b)) { out = b; return true; }
+    return false;
+}
+
+Pipeline::Pipeline(const InstructionSource& program,
+                   const PipelineConfig& cfg,
                    BranchPredictor* bp)
-: prog_(program), forwarding_(forwarding_on), bp_(bp) {}
+: prog_(&program), cfg_(cfg), bp_(bp), ras_(cfg.ras_depth), ind_(cfg.indirect),
+  sb_(cfg.store_buffer, cfg.sb_drain_cycles), uop_(cfg.uop_cache, cfg.uop_ways, cfg.uop_repl),
+  lsd_(cfg.lsd_entries), dc_(cfg.dcache_lines, cfg.dcache_ways),
+  itlb_(cfg.itlb_entries, cfg.itlb_ways), dtlb_(cfg.dtlb_entries, cfg.dtlb_ways),
+  l2tlb_(cfg.l2tlb_entries, cfg.l2tlb_ways), pwc_(cfg.pwc_entries, 4),
+  noc_(cfg.noc, cfg.noc_cores, cfg.noc_hop_cycles, cfg.noc_link_flits, cfg.noc_load,
+       cfg.dcache_miss_cycles, DataCache::kLineBytes) {}
 
 void Pipeline::step() {
     // --- Retire (WB) from previous cycle: snapshot MEM/WB so CSV shows WB this cycle ---
     last_wb_ins_   = memwb_.ins;
     last_wb_valid_ = memwb_.valid;
 
+    const uint64_t now = cycle_ + 1;   // cycle number shown in this step's CSV row
+    if (noc_.enabled()) noc_advance(now);
+    rt_.retire(now - 1);
+
+    // CPI stack: charge this cycle to whatever occupies the WB slot
+    m_.cpi_stack[memwb_.valid ? CpiComponent::Base : memwb_.cause]++;
+
     if (memwb_.valid) {
         if (memwb_.ins.op == Opcode::HALT) {
             halted_ = true;
         } else if (memwb_.ins.op != Opcode::NOP) {
-            m_.retired++;
+            m_.retired += memwb_.ins.fused ? 2 : 1;
+            m_.activity.rf_reads += (uint64_t)reg_reads(memwb_.ins);
+            m_.activity.rf_writes += (uint64_t)reg_writes(memwb_.ins);
+            record_latency(memwb_.ins, now);
+            SIM_PROBE(ProbeKind::Retire, now, memwb_.ins, 0);
+        }
+    }
+
+    // A DIV still dividing keeps EX (it stays in exmem_), so MEM gets nothing this cycle
+    const bool dividing = exmem_.valid && exmem_.ins.op == Opcode::DIV && div_left_ > 0;
+
+    // --- MEM: stores go into the store buffer, loads search it ---
+    sb_.drain(now);
+    mem_bubble_label_.clear();
+    const bool mem_store = exmem_.valid && exmem_.ins.op == Opcode::STORE;
+    const bool mem_load  = exmem_.valid && exmem_.ins.op == Opcode::LOAD && !early_in_mem_;
+    if (mem_store || mem_load) {
+        const int64_t addr = effective_address(exmem_.ins);
+        CpiComponent stall_cause = CpiComponent::Base;
+        const uint64_t inum = exmem_.ins.t_fetch + 1;
+        if (dtlb_.enabled() && dxlate_inum_ != inum) {
+            dxlate_inum_ = inum;
+            dxlate_wait_ = translate(addr, true);
         }
+        if (dtlb_.enabled() && dxlate_wait_ > 0) {
+            dxlate_wait_--;
+            stall_cause = CpiComponent::Memory;
+            mem_bubble_label_ = "STALL_DTLB";
+            m_.stalls.dtlb_miss++;
+        } else if (mem_store) {
+            if (sb_.enabled() && sb_.full()) {
+                stall_cause = CpiComponent::Structural;
+                mem_bubble_label_ = "STALL_SB";
+                m_.stalls.sb_full++;
+            } else {
+                if (sb_.enabled()) sb_.push(addr, now);
+                if (dc_.enabled()) dcache_access(addr, false);
+                m_.mem.stores++;
+            }
+        } else {
+            switch (sb_.enabled() ? sb_.lookup(addr) : StoreBuffer::Lookup::Miss) {
+                case StoreBuffer::Lookup::Partial:
+                    stall_cause = CpiComponent::Memory;
+                    mem_bubble_label_ = "STALL_STLF";
+                    m_.stalls.stlf_partial++;
+                    break;
+                case StoreBuffer::Lookup::Forward: m_.mem.stlf_forwards++; m_.mem.loads++; break;
+                case StoreBuffer::Lookup::Miss:
+                    if (dc_.enabled() && dcache_access(addr, true)) {
+                        stall_cause = CpiComponent::Memory;
+                        mem_bubble_label_ = "STALL_DCACHE";
+                        m_.stalls.dcache_miss++;
+                        break;
+                    }
+                    m_.mem.loads++;
+                    break;
+            }
+        }
+        if (stall_cause != CpiComponent::Base) {
+            // MEM holds its instruction and everything behind it; a bubble goes to WB
+            memwb_ = { Instruction{Opcode::NOP}, false, stall_cause };
+            ex_bubble_label_.clear();    // a held ID bubble is not a new stall
+            rt_.slip(now);
+            SIM_PROBE(ProbeKind::MemStall, now, exmem_.ins, stall_cause);
+            cycle_++;
+            m_.cycles++;
+            return;
+        }
+        rt_.reserve(now, ReservationTable::kMemPort);
+    }
+
+    // --- Early loads: a LOAD may read memory in EX, ahead of the store in MEM ---
+    bool ex_load_early = false;
+    if (cfg_.early_loads != EarlyLoads::Off && control_flush_bubbles_ == 0 &&
+        idex_.valid && idex_.ins.op == Opcode::LOAD) {
+        const int64_t addr = effective_address(idex_.ins);
+        const bool conflict = mem_store && accesses_overlap(addr, effective_address(exmem_.ins));
+        const auto sb_hit = sb_.enabled() ? sb_.lookup(addr) : StoreBuffer::Lookup::Miss;
+        if (cfg_.unified_memory && !rt_.free(now, ReservationTable::kMemPort)) {
+            // The one memory port is the store's in MEM this cycle
+        } else if ((dtlb_.enabled() && !dtlb_.probe(vpn_of(addr))) ||
+            (dc_.enabled() && sb_hit == StoreBuffer::Lookup::Miss && !dc_.probe(addr))) {
+            // A TLB or D-cache miss can't be served early; the load waits for MEM
+        } else if (cfg_.early_loads == EarlyLoads::StoreSets && ss_.load_must_wait(idex_.ins.pc)) {
+            m_.mem.held_loads++;
+            if (!conflict) m_.mem.false_dependences++;
+        } else if (sb_hit != StoreBuffer::Lookup::Partial) {
+            ex_load_early = true;
+            m_.mem.early_loads++;
+            if (conflict) {
+                // Memory-order violation: the load read stale data. Squash it and
+                // everything younger, refetch it; the store moves on to WB.
+                m_.mem.order_violations++;
+                m_.mem.replay_bubbles += 2;
+                if (cfg_.early_loads == EarlyLoads::StoreSets) ss_.violation(idex_.ins.pc, exmem_.ins.pc);
+                ss_.store_done(exmem_.ins.pc, exmem_.ins.t_fetch);
+                SIM_PROBE(ProbeKind::Replay, now, idex_.ins, exmem_.ins.pc);
+
+                memwb_ = { exmem_.ins, true, exmem_.cause };
+                memwb_.ins.d_mem = (uint32_t)(now - memwb_.ins.t_fetch);
+                exmem_ = { Instruction{Opcode::NOP}, false, CpiComponent::Memory };
+                const int replay_pc = idex_.ins.pc;
+                idex_  = { Instruction{Opcode::NOP}, false, CpiComponent::Memory };
+                ex_bubble_label_ = "STALL_REPLAY";
+                early_in_mem_ = false;
+                ifid_ = fetch_stage(replay_pc, now);
+                rt_.clear_after(now);
+                cycle_++;
+                m_.cycles++;
+                return;
+            }
+            m_.mem.loads++;
+            rt_.reserve(now, ReservationTable::kMemPort);
+            if (dtlb_.enabled()) translate(addr, true);           // hits (probed above)
+            if (sb_hit == StoreBuffer::Lookup::Forward) m_.mem.stlf_forwards++;
+            else if (dc_.enabled()) dcache_access(addr, true);   // a hit (probed above)
+        }
+    }
+    if (mem_store) ss_.store_done(exmem_.ins.pc, exmem_.ins.t_fetch);
+
+    // --- Decode-stage fusion: pair the instruction in ID with the next one fetch would bring ---
+    Instruction id_ins = ifid_.ins;
+    std::optional<FusionRule> fusion;
+    if (cfg_.fusion_rules && ifid_.valid && pc_ == id_ins.pc + 1 && pc_ < prog_->size() &&
+        may_start_fusion(cfg_.fusion_rules, id_ins.op)) {
+        fusion = try_fuse(cfg_.fusion_rules, id_ins, prog_->at(pc_));
+        fetch_lo_ = std::min(fetch_lo_, pc_);   // decode looked at it
+        fetch_hi_ = std::max(fetch_hi_, pc_);
     }
 
     // --- Data hazard check for the instruction currently in ID stage (ifid_) ---
+    // (a DIV still dividing is the one in EX, and MEM is empty)
     HazardDecision hz = detect_hazard_for_ID(
-        ifid_.ins,  ifid_.valid,   // ID
-        idex_.ins,  idex_.valid,   // EX
-        exmem_.ins, exmem_.valid,  // MEM
+        id_ins,     ifid_.valid,   // ID
+        dividing ? exmem_.ins : idex_.ins, dividing || idex_.valid,   // EX
+        exmem_.ins, exmem_.valid && !dividing,                         // MEM
         memwb_.ins, memwb_.valid,  // WB
-        forwarding_
+        cfg_.forwarding ? cfg_.bypass_paths : 0,
+        ex_load_early,
+        ifid_.valid && resolves_in_id(id_ins),
+        early_in_mem_
     );
 
     // ---------- Compute next pipeline registers (WB <- MEM <- EX <- ID) ----------
-    MEMWB next_wb  = { exmem_.ins, exmem_.valid }; // WB gets previous EX/MEM
-    EXMEM next_ex  = { idex_.ins,  idex_.valid  }; // EX gets previous ID/EX (shown as EX in CSV)
-    IDEX  next_id  = { ifid_.ins,  ifid_.valid  }; // ID gets previous IF/ID
+    MEMWB next_wb  = { exmem_.ins, exmem_.valid, exmem_.cause }; // WB gets previous EX/MEM
+    EXMEM next_ex  = { idex_.ins,  idex_.valid,  idex_.cause  }; // EX gets previous ID/EX (shown as EX in CSV)
+    IDEX  next_id  = { ifid_.ins,  ifid_.valid,  ifid_.cause  }; // ID gets previous IF/ID
     IFID  next_if  =  ifid_;                       // IF/ID defaults to hold; fetch may overwrite
+    next_wb.ins.d_mem = (uint32_t)(now - next_wb.ins.t_fetch);
+    next_ex.ins.d_ex  = (uint32_t)(now - next_ex.ins.t_fetch);
+    next_id.ins.d_id  = (uint32_t)(now - next_id.ins.t_fetch);
+    if (dividing) {
+        // The divider keeps EX for another cycle; ID was held (book_resources), so idex_ is empty
+        next_wb = { Instruction{Opcode::NOP}, false, CpiComponent::Structural };
+        next_ex = exmem_;
+        div_left_--;
+    } else if (idex_.valid && idex_.ins.op == Opcode::DIV) {
+        div_left_ = cfg_.div_cycles - 1;
+        m_.resources.divides++;
+    }
+
+    // -------- Branch / jump resolution at EX (the instruction that was in ID last cycle) --------
+    // Done before ID acts, so a redirect also squashes the wrong-path instruction
+    // in ID: it never predicts, touches the RAS or reaches EX.
+    bool redirect = false;
+    if (idex_.valid && (is_jump(idex_.ins) || (bp_ && is_branch(idex_.ins) && !resolves_in_id(idex_.ins)))) {
+        const Instruction& br = idex_.ins;
+        Prediction pred;
+        const auto it = pred_by_id_.find(br.id);
+        const bool have_pred = it != pred_by_id_.end();
+        if (have_pred) { pred = it->second; pred_by_id_.erase(it); }
+
+        int actual_pc;
+        bool wrong;
+        if (is_branch(br)) {
+            const bool actual = actual_taken_of(br);
+            SIM_PROBE(ProbeKind::Resolve, now, br, actual);
+            actual_pc = actual ? ctl_pc(br) + 1 + br.imm : ctl_pc(br) + 1;
+            wrong = pred.taken != actual;
+            if (wrong) m_.bp_mispredictions++;
+            // Train predictors with ground truth
+            bp_->update(ctl_pc(br), actual);
+            ind_.push_branch(actual);
+        } else {
+            actual_pc = jump_target(br);
+            SIM_PROBE(ProbeKind::Resolve, now, br, 1);
+            wrong = !have_pred || pred.next_pc != actual_pc;
+            if (br.op == Opcode::JALR && !is_return(br)) {
+                if (wrong) m_.target_mispredictions++;
+                ind_.update(br.pc, actual_pc);
+            } else {
+                if (wrong && is_return(br)) m_.calls.return_mispredicts++;
+                ind_.push_target(actual_pc);
+            }
+        }
+
+        if (wrong) {
+            // Mispredict: redirect, undo wrong-path RAS updates and flush IF & ID
+            // (this cycle's squash plus two more bubble cycles)
+            redirect = true;
+            control_flush_bubbles_ = 2;
+            m_.activity.flushes++;
+            if (cfg_.wrong_path) {
+                // The instruction squashed in ID came down the wrong path; fetch
+                // keeps following it until the redirect reaches IF
+                wp_pc_ = ifid_.valid ? execute_wrong_path(ifid_.ins) : pc_;
+            }
+            pc_ = actual_pc;
+            if (lsd_.covers(pc_) || uop_.contains(pc_)) {
+                // Decoded target is at hand: the refill skips decode
+                control_flush_bubbles_--;
+                m_.frontend.short_redirects++;
+            }
+            if (have_pred && cfg_.ras_depth > 0) ras_.repair(pred.ras);
+            SIM_PROBE(ProbeKind::Mispredict, now, br, pc_);
+        }
+    }
+    // Link values: JAL/JALR write PC+1 (after JALR read its base), anything else clears
+    if (idex_.valid && idex_.ins.rd > 0)
+        link_[idex_.ins.rd] = is_jump(idex_.ins) ? idex_.ins.pc + 1 : 0;
+    if (idex_.valid && idex_.ins.fused && idex_.ins.rd2 > 0) link_[idex_.ins.rd2] = 0;
 
     // -------- Decide fetch behaviour & potential ID bubble insertion --------
     bool can_fetch = true;
     int  fetch_pc  = pc_; // default is to continue from pc_
 
-    if (control_flush_bubbles_ > 0) {
+    // Wrong path: one fetch per cycle down the predicted path until the redirect reaches IF
+    auto wrong_path_fetch = [&]() {
+        if (wp_pc_ < 0 || wp_pc_ >= prog_->size()) { wp_pc_ = -1; return; }
+        if (!fetch_port_free(wp_pc_, now)) return;
+        fetch_lo_ = std::min(fetch_lo_, wp_pc_);
+        fetch_hi_ = std::max(fetch_hi_, wp_pc_);
+        if (itlb_.enabled() && !lsd_.covers(wp_pc_) && !uop_.contains(wp_pc_))
+            translate((int64_t)wp_pc_ * kInstrBytes, false, true);
+        wp_pc_ = execute_wrong_path(fetch_decoded(wp_pc_));
+    };
+
+    if (redirect) {
+        // Squash the wrong-path instructions in ID and IF
+        next_id = { Instruction{Opcode::NOP}, false, CpiComponent::Control };
+        next_if = IFID{ Instruction{Opcode::NOP}, false, CpiComponent::Control };
+        ex_bubble_label_ = "STALL_CTRL";
+        can_fetch = false;
+        m_.stalls.control++;
+        if (cfg_.wrong_path) wrong_path_fetch();
+        SIM_PROBE(ProbeKind::BubbleInsert, now, ifid_.ins, CpiComponent::Control);
+    } else if (control_flush_bubbles_ > 0) {
         // Control hazard flush: insert a bubble into the ID→EX slot
-        next_id = { Instruction{Opcode::NOP}, false };
+        next_id = { Instruction{Opcode::NOP}, false, CpiComponent::Control };
         ex_bubble_label_ = "STALL_CTRL";
         can_fetch = false;               // kill fetch this cycle
         control_flush_bubbles_--;
         m_.stalls.control++;             // count bubble cycles individually
+        if (cfg_.wrong_path) {
+            wrong_path_fetch();
+            if (control_flush_bubbles_ == 0) wp_pc_ = -1;
+        }
+        SIM_PROBE(ProbeKind::BubbleInsert, now, ifid_.ins, CpiComponent::Control);
     } else if (hz.stall) {
         // Data hazard stall: bubble ID→EX and hold IF/ID; do not fetch
-        next_id = { Instruction{Opcode::NOP}, false };
+        next_id = { Instruction{Opcode::NOP}, false,
+                    hz.load_use ? CpiComponent::LoadUse : CpiComponent::Raw };
         ex_bubble_label_ = "STALL_RAW";
         can_fetch = false;
         m_.stalls.raw++;
+        if (hz.branch_operand) m_.branch_resolve.operand_stalls++;
+        if (hz.missing_bypass >= 0) m_.bypass.missing[hz.missing_bypass]++;
+        SIM_PROBE(ProbeKind::StallDecision, now, ifid_.ins, hz.load_use);
+        SIM_PROBE(ProbeKind::BubbleInsert, now, ifid_.ins, next_id.cause);
+    } else if (ifid_.valid && !book_resources(id_ins, now)) {
+        // Structural hazard: a resource the slot needs is taken; bubble ID→EX and hold IF/ID
+        next_id = { Instruction{Opcode::NOP}, false, CpiComponent::Structural };
+        ex_bubble_label_ = "STALL_STRUCT";
+        can_fetch = false;
+        m_.stalls.structural++;
+        SIM_PROBE(ProbeKind::BubbleInsert, now, ifid_.ins, CpiComponent::Structural);
     } else {
         ex_bubble_label_.clear();        // normal advance; no bubble from ID
-        // Perform branch prediction at ID to choose next fetch PC
-        if (bp_ && ifid_.valid && is_branch(ifid_.ins)) {
-            bool pred = bp_->predict(ifid_.ins.pc);
-            m_.bp_predictions++;
-            pred_taken_by_id_[ifid_.ins.id] = pred;
-            int target  = ifid_.ins.pc + 1 + ifid_.ins.imm;
-            int fall_th = ifid_.ins.pc + 1;
-            fetch_pc = pred ? target : fall_th;
-        } else {
+        for (int p = 0; p < kNumBypassPaths; ++p) m_.bypass.used[p] += hz.bypassed[p];
+        if (fusion) {
+            // The tail rides in this slot; fetch skips it (but the front end delivered it)
+            next_id.ins = id_ins;
+            next_id.ins.d_id = (uint32_t)(now - id_ins.t_fetch);
+            fetch_decoded(pc_++);
+            m_.fusion.pairs++;
+            m_.fusion.by_rule[(int)*fusion]++;
+        }
+        // Predict branches and jumps at ID to choose next fetch PC
+        if (ifid_.valid && (is_jump(id_ins) || (bp_ && is_branch(id_ins))))
+            fetch_pc = predict_at_id(id_ins, now);
+        else
             fetch_pc = pc_;
+        // Branch comparator in ID: the outcome is known at the end of the cycle,
+        // too late for this fetch, which went to the predicted PC
+        if (ifid_.valid && resolves_in_id(id_ins)) {
+            const int actual_pc = resolve_at_id(id_ins, now);
+            if (actual_pc != fetch_pc) {
+                if (cfg_.wrong_path && fetch_pc >= 0 && fetch_pc < prog_->size())
+                    execute_wrong_path(fetch_decoded(fetch_pc));
+                next_if = IFID{ Instruction{Opcode::NOP}, false, CpiComponent::Control };
+                can_fetch = false;
+                pc_ = actual_pc;
+                m_.stalls.control++;
+                SIM_PROBE(ProbeKind::Mispredict, now, id_ins, pc_);
+            }
         }
     }
 
     // -------- Fetch into IF/ID (only if allowed) --------
-    if (can_fetch) {
-        if (!halted_ && fetch_pc >= 0 && fetch_pc < (int)prog_.size()) {
-            next_if.ins = prog_[fetch_pc];
-            next_if.valid = true;
-            pc_ = fetch_pc + 1; // default next sequential
-        } else {
-            next_if.ins = Instruction{Opcode::NOP};
-            next_if.valid = false;
-        }
-    } // else: hold IF/ID and do not change pc_
-
-    // -------- Branch resolution at EX (the instruction that was in ID last cycle) --------
-    if (idex_.valid && is_branch(idex_.ins) && bp_) {
-        bool actual = actual_taken_of(idex_.ins);
-        bool predicted = false;
-        if (auto it = pred_taken_by_id_.find(idex_.ins.id); it != pred_taken_by_id_.end()) {
-            predicted = it->second;
-        }
-
-        if (predicted != actual) {
-            // Mispredict: redirect and flush IF & ID in the *next* two cycles (bubble count)
-            m_.bp_mispredictions++;
-            control_flush_bubbles_ = 2;
-
-            int target  = idex_.ins.pc + 1 + idex_.ins.imm;
-            int fall_th = idex_.ins.pc + 1;
-            pc_ = actual ? target : fall_th;
-
-            // Squash any wrong-path fetch we may have placed for the upcoming cycle
-            next_if.ins = Instruction{Opcode::NOP};
-            next_if.valid = false;
-        }
-
-        // Train predictor with ground truth
-        bp_->update(idex_.ins.pc, actual);
-        pred_taken_by_id_.erase(idex_.ins.id);
-    }
+    if (can_fetch) next_if = fetch_stage(fetch_pc, now);
+    // else: hold IF/ID and do not change pc_
 
     // -------- Commit new stage registers --------
     memwb_ = next_wb;
     exmem_ = next_ex;
     idex_  = next_id;
     ifid_  = next_if;
+    early_in_mem_ = ex_load_early;
+    if (idex_.valid && idex_.ins.op == Opcode::STORE) ss_.store_issued(idex_.ins.pc, idex_.ins.t_fetch);
 
     // Bookkeeping
     cycle_++;
     m_.cycles++;
 }
 
+IFID Pipeline::fetch_stage(int fetch_pc, uint64_t now) {
+    IFID next_if;
+    if (!halted_ && fetch_pc >= 0) {
+        fetch_lo_ = std::min(fetch_lo_, fetch_pc);
+        fetch_hi_ = std::max(fetch_hi_, fetch_pc);
+    }
+    const bool in_range = !halted_ && fetch_pc >= 0 && fetch_pc < prog_->size();
+    // The micro-op cache and loop buffer are virtually addressed; only a
+    // fetch from the instruction source needs its translation
+    if (in_range && itlb_.enabled() && ixlate_pc_ != fetch_pc &&
+        !lsd_.covers(fetch_pc) && !uop_.contains(fetch_pc)) {
+        ixlate_pc_ = fetch_pc;
+        ixlate_wait_ = translate((int64_t)fetch_pc * kInstrBytes, false);
+    }
+    if (in_range && ixlate_pc_ == fetch_pc && ixlate_wait_ > 0) {
+        // iTLB miss: IF stays empty until the translation arrives, then fetches from here
+        ixlate_wait_--;
+        m_.stalls.itlb_miss++;
+        pc_ = fetch_pc;
+        next_if.ins = Instruction{Opcode::NOP};
+        next_if.valid = false;
+        next_if.cause = CpiComponent::Fetch;
+    } else if (in_range && !fetch_port_free(fetch_pc, now)) {
+        // Unified memory: the LOAD/STORE in MEM has the port; fetch retries next cycle
+        m_.stalls.structural++;
+        m_.resources.mem_port++;
+        pc_ = fetch_pc;
+        next_if.ins = Instruction{Opcode::NOP};
+        next_if.valid = false;
+        next_if.cause = CpiComponent::Structural;
+    } else if (in_range) {
+        ixlate_pc_ = -1;
+        next_if.ins = fetch_decoded(fetch_pc);
+        next_if.ins.t_fetch = now;
+        next_if.valid = true;
+        SIM_PROBE(ProbeKind::Fetch, now, next_if.ins, 0);
+        pc_ = fetch_pc + 1; // default next sequential
+    } else {
+        // Past either end (a jump or branch predicted off the program): fetch stays
+        // stopped here until a redirect, instead of carrying on from the old PC
+        pc_ = fetch_pc;
+        next_if.ins = Instruction{Opcode::NOP};
+        next_if.valid = false;
+        next_if.cause = CpiComponent::Fetch;
+    }
+    return next_if;
+}
+
+int Pipeline::predict_at_id(const Instruction& ins, [[maybe_unused]] uint64_t now) {
+    Prediction p;
+    p.next_pc = ctl_pc(ins) + 1;
+    if (is_branch(ins)) {
+        p.taken = bp_->predict(ctl_pc(ins));
+        m_.bp_predictions++;
+        SIM_PROBE(ProbeKind::BranchPredict, now, ins, p.taken);
+        if (p.taken) p.next_pc = ctl_pc(ins) + 1 + ins.imm;
+    } else {
+        p.taken = true;
+        if (ins.op == Opcode::JAL) {
+            p.next_pc = ins.pc + 1 + ins.imm;   // known at decode
+        } else if (!is_return(ins)) {
+            p.next_pc = ind_.predict(ins.pc, ins.pc + 1);
+            m_.target_predictions++;
+        }
+        if (is_return(ins)) {
+            m_.calls.returns++;
+            if (cfg_.ras_depth > 0 && !ras_.pop(p.next_pc)) m_.calls.ras_underflows++;
+        }
+        if (is_call(ins)) {
+            m_.calls.calls++;
+            if (cfg_.ras_depth > 0 && !ras_.push(ins.pc + 1)) m_.calls.ras_overflows++;
+        }
+    }
+    p.ras = ras_.checkpoint();
+    pred_by_id_[ins.id] = p;
+    if (p.taken && lsd_.taken(ctl_pc(ins), p.next_pc)) m_.frontend.lsd_locks++;
+    return p.next_pc;
+}
+
+int Pipeline::resolve_at_id(const Instruction& br, [[maybe_unused]] uint64_t now) {
+    const auto it = pred_by_id_.find(br.id);
+    const bool predicted_taken = it->second.taken;
+    pred_by_id_.erase(it);
+
+    const bool actual = actual_taken_of(br);
+    SIM_PROBE(ProbeKind::Resolve, now, br, actual);
+    m_.branch_resolve.id_resolved++;
+    bp_->update(br.pc, actual);
+    ind_.push_branch(actual);
+    if (predicted_taken != actual) {
+        m_.bp_mispredictions++;
+        m_.activity.flushes++;
+    }
+    return actual ? br.pc + 1 + br.imm : br.pc + 1;
+}
+
+bool Pipeline::book_resources(const Instruction& ins, uint64_t now) {
+    // EX (now + 1 on): nothing may enter while the divider works, and a DIV keeps it div_cycles
+    const int ex_cycles = ins.op == Opcode::DIV ? cfg_.div_cycles : 1;
+    for (int c = 1; c <= ex_cycles; ++c)
+        if (!rt_.free(now + c, ReservationTable::kDivider)) { m_.resources.divider++; return false; }
+    // WB: one write port per result; results beyond the ports are written a cycle later
+    const uint64_t wb = now + ex_cycles + 2;
+    const uint32_t wports = ReservationTable::write_ports(cfg_.rf_write_ports);
+    const int writes = cfg_.rf_write_ports ? reg_writes(ins) : 0;
+    const int first = std::min(writes, cfg_.rf_write_ports);
+    if (rt_.free_units(wb, wports) < first || rt_.free_units(wb + 1, wports) < writes - first) {
+        m_.resources.rf_write++;
+        return false;
+    }
+    // ID: operands are read over as many cycles as the read ports need
+    if (cfg_.rf_read_ports) {
+        if (id_read_inum_ != ins.t_fetch + 1) {
+            id_read_inum_ = ins.t_fetch + 1;
+            id_reads_left_ = reg_reads(ins);
+        }
+        id_reads_left_ -= rt_.claim(now, ReservationTable::read_ports(cfg_.rf_read_ports), id_reads_left_);
+        if (id_reads_left_ > 0) { m_.resources.rf_read++; return false; }
+    }
+    if (ins.op == Opcode::DIV)
+        for (int c = 1; c <= ex_cycles; ++c) rt_.reserve(now + c, ReservationTable::kDivider);
+    rt_.claim(wb, wports, first);
+    rt_.claim(wb + 1, wports, writes - first);
+    return true;
+}
+
+bool Pipeline::dcache_access(int64_t addr, bool is_load) {
+    if (!dc_pending_) {
+        m_.mem.dcache_accesses++;
+        const DataCache::Result r = dc_.access(addr);
+        if (r == DataCache::Result::PrefetchHit) m_.wrong_path.prefetch_hits++;
+        if (r == DataCache::Result::Miss || r == DataCache::Result::PollutionMiss) {
+            m_.mem.dcache_misses++;
+            if (r == DataCache::Result::PollutionMiss) m_.wrong_path.pollution_misses++;
+            // Stores are buffered: only a load waits for the line
+            int wait = cfg_.dcache_miss_cycles;
+            if (noc_.enabled()) {
+                wait = noc_.fetch_line(DataCache::line_of(addr), cycle_ + 1, is_load);
+                if (is_load) {
+                    m_.noc.requests++;
+                    m_.noc.request_cycles += (uint64_t)wait;
+                }
+                noc_advance(cycle_ + 1);
+            }
+            if (is_load && wait > 0) {
+                dc_pending_ = true;
+                dc_wait_ = wait;
+            }
+        }
+    }
+    if (dc_pending_ && dc_wait_ > 0) {
+        dc_wait_--;
+        return true;
+    }
+    dc_pending_ = false;
+    return false;
+}
+
+int Pipeline::execute_wrong_path(const Instruction& ins) {
+    m_.wrong_path.instructions++;
+    if (ins.op == Opcode::LOAD && dtlb_.enabled()) translate(effective_address(ins), true, true);
+    if (ins.op == Opcode::LOAD) m_.wrong_path.loads++;   // an L1d read, like a correct-path load
+    if (ins.op == Opcode::LOAD && dc_.enabled()) {
+        if (dc_.access_wrong_path(effective_address(ins))) {
+            m_.wrong_path.fills++;
+            if (noc_.enabled()) noc_.fetch_line(DataCache::line_of(effective_address(ins)), cycle_ + 1, false);
+        }
+    }
+    // Follow the predictions fetch would have made (peeked: not counted, no table touched)
+    if (is_branch(ins) && bp_ && bp_->peek(ins.pc)) return ins.pc + 1 + ins.imm;
+    if (ins.op == Opcode::JAL) return ins.pc + 1 + ins.imm;
+    if (ins.op == Opcode::JALR) return is_return(ins) ? -1 : ind_.predict(ins.pc, -1);
+    if (ins.op == Opcode::HALT) return -1;
+    return ins.pc + 1;
+}
+
+void Pipeline::noc_advance(uint64_t now) {
+    noc_.advance(now);
+    const Noc::Stats& n = noc_.stats();
+    m_.noc.packets = n.packets;
+    m_.noc.packet_cycles = n.packet_cycles;
+    m_.noc.queue_cycles = n.queue_cycles;
+    m_.noc.hops = n.hops;
+}
+
+int Pipeline::translate(int64_t vaddr, bool data, bool wrong_path) {
+    const uint64_t vpn = vpn_of(vaddr);
+    TlbStats& t = m_.tlb;
+    Tlb& l1 = data ? dtlb_ : itlb_;
+    (data ? t.dtlb_accesses : t.itlb_accesses)++;
+    if (l1.lookup(vpn)) return 0;
+    (data ? t.dtlb_misses : t.itlb_misses)++;
+
+    int cycles = 0;
+    bool l2_hit = false;
+    if (l2tlb_.enabled()) {
+        t.l2_accesses++;
+        cycles += cfg_.l2tlb_cycles;
+        l2_hit = l2tlb_.lookup(vpn);
+        if (!l2_hit) t.l2_misses++;
+    }
+    if (!l2_hit) {
+        // Walk from just below the deepest upper-level entry the page-walk cache holds
+        int refs = cfg_.walk_levels;
+        for (int level = 2; level <= cfg_.walk_levels && pwc_.enabled(); ++level)
+            if (pwc_.lookup(pwc_key(level, vpn))) { refs = level - 1; t.pwc_hits++; break; }
+        for (int level = 2; level <= refs && pwc_.enabled(); ++level) pwc_.insert(pwc_key(level, vpn));
+        t.walks++;
+        t.walk_refs += refs;
+        cycles += refs * cfg_.walk_level_cycles;
+        if (l2tlb_.enabled()) l2tlb_.insert(vpn);
+    }
+    l1.insert(vpn);
+    if (wrong_path) return 0;
+    t.cycles += cycles;
+    return cycles;
+}
+
+Instruction Pipeline::fetch_decoded(int pc) {
+    m_.frontend.fetches++;
+    if (const Instruction* ins = lsd_.lookup(pc)) {
+        m_.frontend.lsd_hits++;
+        return *ins;
+    }
+    Instruction ins;
+    if (const Instruction* hit = uop_.lookup(pc)) {
+        m_.frontend.uop_hits++;
+        ins = *hit;
+    } else {
+        ins = prog_->at(pc);
+        m_.frontend.decodes++;
+        if (uop_.enabled()) {
+            m_.frontend.uop_misses++;
+            if (uop_.insert(ins)) m_.frontend.uop_evictions++;
+        }
+    }
+    lsd_.capture(ins);
+    return ins;
+}
+
+void Pipeline::record_latency(const Instruction& ins, uint64_t retire_cycle) {
+    // A fused slot retires two instructions with the same timing
+    for (int half = 0; half <= (int)ins.fused; ++half) {
+        const int c = (int)op_class(half ? ins.fused_op : ins.op);
+        auto& lat = m_.latency;
+        lat.total[c].record(retire_cycle - ins.t_fetch + 1);
+        lat.stage[c][(int)StageId::IF ].record(ins.d_id);
+        lat.stage[c][(int)StageId::ID ].record(ins.d_ex  - ins.d_id);
+        lat.stage[c][(int)StageId::EX ].record(ins.d_mem - ins.d_ex);
+        lat.stage[c][(int)StageId::MEM].record(retire_cycle - ins.t_fetch - ins.d_mem);
+    }
+}
+
 std::string Pipeline::csv_row() const {
     auto ins_str = [](const Instruction& ins, bool v) {
         if (!v) return std::string("-");
+        if (ins.fused) return opcode_name(ins.op) + "+" + opcode_name(ins.fused_op) + "#" + std::to_string(ins.id);
         return opcode_name(ins.op) + "#" + std::to_string(ins.id);
     };
 
@@ -128,6 +653,11 @@ std::string Pipeline::csv_row() const {
         if (!idex_.valid && !ex_bubble_label_.empty()) return ex_bubble_label_;
         return ins_str(idex_.ins, idex_.valid);
     };
+    // ... and a MEM stall's in the MEM column
+    auto mem_cell = [&]() -> std::string {
+        if (!memwb_.valid && !mem_bubble_label_.empty()) return mem_bubble_label_;
+        return ins_str(memwb_.ins, memwb_.valid);
+    };
 
     std::ostringstream oss;
     // 6 columns: cycle,IF,ID,EX,MEM,WB
@@ -135,7 +665,190 @@ std::string Pipeline::csv_row() const {
         << ins_str(ifid_.ins,  ifid_.valid)   << ","
         << id_cell()                          << ","
         << ins_str(exmem_.ins, exmem_.valid)  << ","
-        << ins_str(memwb_.ins, memwb_.valid)  << ","
+        << mem_cell()                         << ","
         << ins_str(last_wb_ins_, last_wb_valid_);
     return oss.str();
 }
+
+void Pipeline::timeline_row(TimelineRow& row) const {
+    auto put = [](TimelineCell& c, const Instruction& ins, bool v) {
+        c.kind = v ? TimelineCell::Instr : TimelineCell::Empty;
+        c.code = v ? (uint8_t)ins.op : 0;
+        c.id   = v ? ins.id : -1;
+    };
+    row.cycle = cycle_;
+    put(row.cell[0], ifid_.ins, ifid_.valid);
+    put(row.cell[1], idex_.ins, idex_.valid);
+    if (!idex_.valid && !ex_bubble_label_.empty()) {
+        row.cell[1].kind = TimelineCell::Stall;
+        row.cell[1].code = (uint8_t)idex_.cause;
+    }
+    put(row.cell[2], exmem_.ins, exmem_.valid);
+    put(row.cell[3], memwb_.ins, memwb_.valid);
+    if (!memwb_.valid && !mem_bubble_label_.empty()) {
+        row.cell[3].kind = TimelineCell::Stall;
+        row.cell[3].code = (uint8_t)memwb_.cause;
+    }
+    put(row.cell[4], last_wb_ins_, last_wb_valid_);
+}
+
+// ------------------------------ checkpointing ------------------------------
+
+uint64_t Pipeline::state_hash() const {
+    uint64_t h = kHashSeed;
+    auto reg = [&](const Instruction& ins, bool valid, CpiComponent cause) {
+        h = hash_mix(h, valid);
+        if (!valid) { h = hash_mix(h, (uint64_t)cause); return; }
+        h = hash_mix(h, content_hash(ins));
+        h = hash_mix(h, (uint64_t)(int64_t)ins.pc);
+        h = hash_mix(h, (uint64_t)(int64_t)ins.id);
+        h = hash_mix(h, cycle_ - ins.t_fetch);     // age, not absolute time
+        h = hash_mix(h, ((uint64_t)ins.d_id << 32) | ins.d_ex);
+        h = hash_mix(h, ins.d_mem);
+    };
+    reg(ifid_.ins,  ifid_.valid,  ifid_.cause);
+    reg(idex_.ins,  idex_.valid,  idex_.cause);
+    reg(exmem_.ins, exmem_.valid, exmem_.cause);
+    reg(memwb_.ins, memwb_.valid, memwb_.cause);
+    reg(last_wb_ins_, last_wb_valid_, CpiComponent::Base);
+
+    h = hash_mix(h, (uint64_t)(int64_t)pc_);
+    h = hash_mix(h, halted_);
+    h = hash_mix(h, (uint64_t)control_flush_bubbles_);
+    for (char c : ex_bubble_label_) h = hash_mix(h, (uint64_t)(unsigned char)c);
+    for (char c : mem_bubble_label_) h = hash_mix(h, (uint64_t)(unsigned char)c);
+    sb_.for_each(cycle_, [&](int64_t v) { h = hash_mix(h, (uint64_t)v); });
+    h = hash_mix(h, early_in_mem_);
+    if (cfg_.early_loads == EarlyLoads::StoreSets)
+        ss_.for_each(cycle_, [&](uint64_t v) { h = hash_mix(h, v); });
+
+    std::vector<std::pair<int, Prediction>> pending(pred_by_id_.begin(), pred_by_id_.end());
+    std::sort(pending.begin(), pending.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& [id, p] : pending) {
+        h = hash_mix(h, ((uint64_t)(uint32_t)id << 1) | p.taken);
+        h = hash_mix(h, ((uint64_t)(uint32_t)p.next_pc << 32) | (uint32_t)p.ras.top_value);
+        h = hash_mix(h, ((uint64_t)(uint32_t)p.ras.top << 32) | (uint32_t)p.ras.count);
+    }
+    ras_.for_each([&](int32_t v) { h = hash_mix(h, (uint64_t)(uint32_t)v); });
+    ind_.for_each([&](uint64_t v) { h = hash_mix(h, v); });
+    for (int32_t v : link_) h = hash_mix(h, (uint64_t)(uint32_t)v);
+    uop_.for_each([&](int slot, const Instruction& ins, uint64_t age) {
+        h = hash_mix(hash_mix(h, ((uint64_t)slot << 32) | (uint32_t)ins.pc), content_hash(ins));
+        h = hash_mix(h, age);
+    });
+    if (cfg_.uop_repl == UopReplacement::Random) h = hash_mix(h, uop_.rng_state());
+    if (lsd_.enabled()) lsd_.for_each([&](uint64_t v) { h = hash_mix(h, v); });
+    if (dc_.enabled()) {
+        dc_.for_each([&](uint64_t slot, uint64_t tag, uint64_t age) {
+            h = hash_mix(hash_mix(hash_mix(h, slot), tag), age);
+        });
+        h = hash_mix(h, ((uint64_t)dc_wait_ << 1) | dc_pending_);
+    }
+    if (cfg_.wrong_path) h = hash_mix(h, (uint64_t)(int64_t)wp_pc_);
+    if (noc_.enabled()) noc_.for_each(cycle_, [&](uint64_t v) { h = hash_mix(h, v); });
+    for (const Tlb* t : {&itlb_, &dtlb_, &l2tlb_, &pwc_})
+        t->for_each([&](uint64_t slot, uint64_t key, uint64_t age) {
+            h = hash_mix(hash_mix(hash_mix(h, slot), key), age);
+        });
+    if (itlb_.enabled()) h = hash_mix(h, ((uint64_t)(uint32_t)ixlate_pc_ << 32) | (uint32_t)ixlate_wait_);
+    if (dtlb_.enabled()) {
+        const bool translated = exmem_.valid && dxlate_inum_ == exmem_.ins.t_fetch + 1;
+        h = hash_mix(h, ((uint64_t)(uint32_t)dxlate_wait_ << 1) | translated);
+    }
+    rt_.for_each(cycle_ + 1, [&](uint32_t r) { h = hash_mix(h, r); });
+    h = hash_mix(h, (uint64_t)div_left_);
+    if (cfg_.rf_read_ports) {
+        const bool reading = ifid_.valid && id_read_inum_ == ifid_.ins.t_fetch + 1;
+        h = hash_mix(h, ((uint64_t)(uint32_t)id_reads_left_ << 1) | reading);
+    }
+
+    if (bp_) {
+        PredictorState st;
+        bp_->save_state(st);
+        std::sort(st.begin(), st.end());
+        for (const auto& [k, v] : st) h = hash_mix(hash_mix(h, k), (uint64_t)v);
+    }
+    return h;
+}
+
+// Host-endian raw layout: checkpoints are a local cache, not an exchange format
+void Pipeline::save_state(std::ostream& os, bool indirect_tables) const {
+    put_raw(os, pc_);
+    put_raw(os, cycle_);
+    put_raw(os, halted_);
+    put_raw(os, ifid_);
+    put_raw(os, idex_);
+    put_raw(os, exmem_);
+    put_raw(os, memwb_);
+    put_raw(os, last_wb_ins_);
+    put_raw(os, last_wb_valid_);
+    put_raw(os, control_flush_bubbles_);
+    put_raw(os, (uint64_t)pred_by_id_.size());
+    for (const auto& [id, p] : pred_by_id_) { put_raw(os, id); put_raw(os, p); }
+    put_raw(os, ras_);
+    if (indirect_tables && cfg_.indirect != IndirectMode::None) put_raw(os, ind_);
+    put_raw(os, link_);
+    for (const std::string* label : {&ex_bubble_label_, &mem_bubble_label_}) {
+        put_raw(os, (uint64_t)label->size());
+        os.write(label->data(), (std::streamsize)label->size());
+    }
+    if (sb_.enabled()) put_raw(os, sb_);
+    if (cfg_.early_loads == EarlyLoads::StoreSets) put_raw(os, ss_);
+    put_raw(os, early_in_mem_);
+    if (uop_.enabled()) put_raw(os, uop_);
+    if (lsd_.enabled()) put_raw(os, lsd_);
+    if (dc_.enabled()) put_raw(os, dc_);
+    put_raw(os, dc_pending_);
+    put_raw(os, dc_wait_);
+    put_raw(os, wp_pc_);
+    for (const Tlb* t : {&itlb_, &dtlb_, &l2tlb_, &pwc_})
+        if (t->enabled()) put_raw(os, *t);
+    put_raw(os, ixlate_pc_);
+    put_raw(os, ixlate_wait_);
+    put_raw(os, dxlate_inum_);
+    put_raw(os, dxlate_wait_);
+    put_raw(os, rt_);
+    put_raw(os, div_left_);
+    put_raw(os, id_read_inum_);
+    put_raw(os, id_reads_left_);
+    put_raw(os, fetch_lo_);
+    put_raw(os, fetch_hi_);
+    put_raw(os, m_);
+    if (noc_.enabled()) noc_.save(os);
+}
+
+bool Pipeline::load_state(std::istream& is, bool indirect_tables) {
+    uint64_t n = 0;
+    if (!(get_raw(is, pc_) && get_raw(is, cycle_) && get_raw(is, halted_) &&
+          get_raw(is, ifid_) && get_raw(is, idex_) && get_raw(is, exmem_) && get_raw(is, memwb_) &&
+          get_raw(is, last_wb_ins_) && get_raw(is, last_wb_valid_) &&
+          get_raw(is, control_flush_bubbles_) && get_raw(is, n)))
+        return false;
+    pred_by_id_.clear();
+    for (uint64_t i = 0; i < n; ++i) {
+        int id; Prediction p;
+        if (!(get_raw(is, id) && get_raw(is, p))) return false;
+        pred_by_id_[id] = p;
+    }
+    if (!get_raw(is, ras_)) return false;
+    if (indirect_tables && cfg_.indirect != IndirectMode::None && !get_raw(is, ind_)) return false;
+    if (!get_raw(is, link_)) return false;
+    for (std::string* label : {&ex_bubble_label_, &mem_bubble_label_}) {
+        if (!get_raw(is, n) || n > 64) return false;
+        label->resize(n);
+        if (!is.read(&(*label)[0], (std::streamsize)n)) return false;
+    }
+    if ((sb_.enabled() && !get_raw(is, sb_)) ||
+        (cfg_.early_loads == EarlyLoads::StoreSets && !get_raw(is, ss_)) || !get_raw(is, early_in_mem_) ||
+        (uop_.enabled() && !get_raw(is, uop_)) || (lsd_.enabled() && !get_raw(is, lsd_)) ||
+        (dc_.enabled() && !get_raw(is, dc_)) || !get_raw(is, dc_pending_) || !get_raw(is, dc_wait_) ||
+        !get_raw(is, wp_pc_))
+        return false;
+    for (Tlb* t : {&itlb_, &dtlb_, &l2tlb_, &pwc_})
+        if (t->enabled() && !get_raw(is, *t)) return false;
+    return get_raw(is, ixlate_pc_) && get_raw(is, ixlate_wait_) && get_raw(is, dxlate_inum_) && get_raw(is, dxlate_wait_) &&
+           get_raw(is, rt_) && get_raw(is, div_left_) && get_raw(is, id_read_inum_) && get_raw(is, id_reads_left_) &&
+           get_raw(is, fetch_lo_) && get_raw(is, fetch_hi_) && get_raw(is, m_) &&
+           (!noc_.enabled() || noc_.load(is));
+}
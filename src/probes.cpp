@@ -0,0 +1,58 @@
+#include "probes.hpp"
+#include <csignal>
+
+const char* probe_kind_name(ProbeKind k) {
+    switch (k) {
+        case ProbeKind::Fetch:         return "fetch";
+        case ProbeKind::StallDecision: return "stall";
+        case ProbeKind::BubbleInsert:  return "bubble";
+        case ProbeKind::BranchPredict: return "predict";
+        case ProbeKind::Resolve:       return "resolve";
+        case ProbeKind::Mispredict:    return "mispredict";
+        case ProbeKind::Retire:        return "retire";
+        case ProbeKind::MemStall:      return "mem_stall";
+        case ProbeKind::Replay:        return "replay";
+    }
+    return "?";
+}
+
+#if CPU_SIM_PROBES
+
+SimProbeRing& probe_ring() {
+    static SimProbeRing ring;
+    return ring;
+}
+
+void probe_dump(std::FILE* out) {
+    const SimProbeRing& r = probe_ring();
+    std::fprintf(out, "# probe ring: last %zu of %llu events\n",
+                 r.size(), (unsigned long long)r.total());
+    std::fputs("cycle,event,id,pc,arg\n", out);
+    for (size_t i = 0; i < r.size(); ++i) {
+        const ProbeEvent& e = r.at(i);
+        std::fprintf(out, "%llu,%s,%d,%d,%d\n",
+                     (unsigned long long)e.cycle, probe_kind_name(e.kind), e.id, e.pc, e.arg);
+    }
+    std::fflush(out);
+}
+
+static void on_crash(int sig) {
+    // best effort: stdio isn't async-signal-safe, but we are going down anyway
+    std::fputs("\n*** cpu-sim crashed; dumping probe ring ***\n", stderr);
+    probe_dump(stderr);
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+}
+
+void probe_install_crash_handler() {
+    std::signal(SIGSEGV, on_crash);
+    std::signal(SIGABRT, on_crash);
+    std::signal(SIGFPE,  on_crash);
+}
+
+#else
+
+void probe_dump(std::FILE*) {}
+void probe_install_crash_handler() {}
+
+#endif
@@ -0,0 +1,437 @@
+#include "report.hpp"
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+static std::string json_str(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n";  break;
+            case '\t': out += "\\t";  break;
+            default:
+                if ((unsigned char)c < 0x20) out += ' ';
+                else out += c;
+        }
+    }
+    return out + "\"";
+}
+
+static void json_num(std::ostream& os, double d) {
+    if (std::isfinite(d)) os << d; else os << "null";
+}
+
+// ------------------------------ fields ------------------------------
+
+static void add(std::vector<ReportField>& out, const std::string& name, uint64_t v) {
+    ReportField f; f.name = name; f.kind = ReportField::U64; f.u = v;
+    out.push_back(std::move(f));
+}
+static void add_f(std::vector<ReportField>& out, const std::string& name, double v) {
+    ReportField f; f.name = name; f.kind = ReportField::F64; f.d = v;
+    out.push_back(std::move(f));
+}
+static void add_s(std::vector<ReportField>& out, const std::string& name, const std::string& v) {
+    ReportField f; f.name = name; f.kind = ReportField::Str; f.s = v;
+    out.push_back(std::move(f));
+}
+
+void append_run_fields(std::vector<ReportField>& out, const RunInfo& run) {
+    add_s(out, "config.trace", run.trace);
+    add_s(out, "config.predictor", run.predictor);
+    add  (out, "config.forwarding", run.pipeline.forwarding ? 1 : 0);
+    add_s(out, "config.bypass", bypass_paths_string(run.pipeline.forwarding ? run.pipeline.bypass_paths : 0));
+    add  (out, "config.store_buffer", (uint64_t)run.pipeline.store_buffer);
+    add  (out, "config.sb_drain_cycles", (uint64_t)run.pipeline.sb_drain_cycles);
+    add_s(out, "config.mem_ports", run.pipeline.unified_memory ? "unified" : "split");
+    add  (out, "config.rf_read_ports", (uint64_t)run.pipeline.rf_read_ports);
+    add  (out, "config.rf_write_ports", (uint64_t)run.pipeline.rf_write_ports);
+    add  (out, "config.div_cycles", (uint64_t)run.pipeline.div_cycles);
+    add_s(out, "config.early_loads", early_loads_name(run.pipeline.early_loads));
+    add_s(out, "config.branch_resolve", branch_resolve_name(run.pipeline.branch_resolve));
+    add  (out, "config.ras_depth", (uint64_t)run.pipeline.ras_depth);
+    add_s(out, "config.indirect", indirect_mode_name(run.pipeline.indirect));
+    add_s(out, "config.fusion", fusion_rules_string(run.pipeline.fusion_rules));
+    add  (out, "config.uop_cache", (uint64_t)run.pipeline.uop_cache);
+    add  (out, "config.uop_ways", (uint64_t)run.pipeline.uop_ways);
+    add_s(out, "config.uop_repl", uop_replacement_name(run.pipeline.uop_repl));
+    add  (out, "config.lsd_entries", (uint64_t)run.pipeline.lsd_entries);
+    add  (out, "config.dcache_lines", (uint64_t)run.pipeline.dcache_lines);
+    add  (out, "config.dcache_ways", (uint64_t)run.pipeline.dcache_ways);
+    add  (out, "config.dcache_miss_cycles", (uint64_t)run.pipeline.dcache_miss_cycles);
+    add  (out, "config.wrong_path", run.pipeline.wrong_path ? 1 : 0);
+    add  (out, "config.itlb_entries", (uint64_t)run.pipeline.itlb_entries);
+    add  (out, "config.itlb_ways", (uint64_t)run.pipeline.itlb_ways);
+    add  (out, "config.dtlb_entries", (uint64_t)run.pipeline.dtlb_entries);
+    add  (out, "config.dtlb_ways", (uint64_t)run.pipeline.dtlb_ways);
+    add  (out, "config.l2tlb_entries", (uint64_t)run.pipeline.l2tlb_entries);
+    add  (out, "config.l2tlb_ways", (uint64_t)run.pipeline.l2tlb_ways);
+    add  (out, "config.l2tlb_cycles", (uint64_t)run.pipeline.l2tlb_cycles);
+    add  (out, "config.page_bytes", (uint64_t)run.pipeline.page_bytes);
+    add  (out, "config.walk_levels", (uint64_t)run.pipeline.walk_levels);
+    add  (out, "config.walk_level_cycles", (uint64_t)run.pipeline.walk_level_cycles);
+    add  (out, "config.pwc_entries", (uint64_t)run.pipeline.pwc_entries);
+    add_s(out, "config.noc", noc_topology_name(run.pipeline.noc));
+    add  (out, "config.noc_cores", (uint64_t)run.pipeline.noc_cores);
+    add  (out, "config.noc_hop_cycles", (uint64_t)run.pipeline.noc_hop_cycles);
+    add  (out, "config.noc_link_flits", (uint64_t)run.pipeline.noc_link_flits);
+    add  (out, "config.noc_load", (uint64_t)run.pipeline.noc_load);
+    for (int e = 0; e < kNumEnergyEvents; ++e)
+        add_f(out, std::string("config.energy_pj.") + energy_event_name((EnergyEvent)e), run.energy.pj[e]);
+    add_f(out, "config.clock_ghz", run.energy.clock_ghz);
+    if (run.timing.enabled) {
+        for (int s = 0; s < kNumPipeStages; ++s)
+            add_f(out, std::string("config.stage_ps.") + pipe_stage_name((PipeStage)s), run.timing.logic_ps[s]);
+        add_f(out, "config.latch_ps", run.timing.latch_ps);
+        add  (out, "config.depth_sweep", (uint64_t)run.timing.sweep_depth);
+    }
+    add  (out, "config.max_cycles", run.max_cycles);
+    add  (out, "config.interval_cycles", run.interval_cycles);
+}
+
+void append_metrics_fields(std::vector<ReportField>& out, const Metrics& m) {
+    add  (out, "metrics.cycles", m.cycles);
+    add  (out, "metrics.retired", m.retired);
+    add_f(out, "metrics.cpi", m.cpi());
+    add  (out, "metrics.bp_predictions", m.bp_predictions);
+    add  (out, "metrics.bp_mispredictions", m.bp_mispredictions);
+    add_f(out, "metrics.bp_accuracy_pct", m.bp_accuracy_pct());
+    add  (out, "metrics.target_predictions", m.target_predictions);
+    add  (out, "metrics.target_mispredictions", m.target_mispredictions);
+    add_f(out, "metrics.target_accuracy_pct", m.target_accuracy_pct());
+
+    add(out, "metrics.stalls.raw", m.stalls.raw);
+    add(out, "metrics.stalls.war", m.stalls.war);
+    add(out, "metrics.stalls.waw", m.stalls.waw);
+    add(out, "metrics.stalls.control", m.stalls.control);
+    add(out, "metrics.stalls.sb_full", m.stalls.sb_full);
+    add(out, "metrics.stalls.stlf_partial", m.stalls.stlf_partial);
+    add(out, "metrics.stalls.dcache_miss", m.stalls.dcache_miss);
+    add(out, "metrics.stalls.itlb_miss", m.stalls.itlb_miss);
+    add(out, "metrics.stalls.dtlb_miss", m.stalls.dtlb_miss);
+    add(out, "metrics.stalls.structural", m.stalls.structural);
+    add(out, "metrics.stalls.total", m.stalls.total());
+
+    add(out, "metrics.mem.loads", m.mem.loads);
+    add(out, "metrics.mem.stores", m.mem.stores);
+    add(out, "metrics.mem.stlf_forwards", m.mem.stlf_forwards);
+    add(out, "metrics.mem.early_loads", m.mem.early_loads);
+    add(out, "metrics.mem.held_loads", m.mem.held_loads);
+    add(out, "metrics.mem.false_dependences", m.mem.false_dependences);
+    add(out, "metrics.mem.order_violations", m.mem.order_violations);
+    add(out, "metrics.mem.replay_bubbles", m.mem.replay_bubbles);
+    add(out, "metrics.mem.dcache_accesses", m.mem.dcache_accesses);
+    add(out, "metrics.mem.dcache_misses", m.mem.dcache_misses);
+
+    add  (out, "metrics.tlb.itlb_accesses", m.tlb.itlb_accesses);
+    add  (out, "metrics.tlb.itlb_misses", m.tlb.itlb_misses);
+    add_f(out, "metrics.tlb.itlb_mpki", m.itlb_mpki());
+    add  (out, "metrics.tlb.dtlb_accesses", m.tlb.dtlb_accesses);
+    add  (out, "metrics.tlb.dtlb_misses", m.tlb.dtlb_misses);
+    add_f(out, "metrics.tlb.dtlb_mpki", m.dtlb_mpki());
+    add  (out, "metrics.tlb.l2_accesses", m.tlb.l2_accesses);
+    add  (out, "metrics.tlb.l2_misses", m.tlb.l2_misses);
+    add_f(out, "metrics.tlb.l2_mpki", m.l2tlb_mpki());
+    add  (out, "metrics.tlb.walks", m.tlb.walks);
+    add  (out, "metrics.tlb.walk_refs", m.tlb.walk_refs);
+    add  (out, "metrics.tlb.pwc_hits", m.tlb.pwc_hits);
+    add  (out, "metrics.tlb.cycles", m.tlb.cycles);
+
+    add  (out, "metrics.branch_resolve.id_resolved", m.branch_resolve.id_resolved);
+    add  (out, "metrics.branch_resolve.operand_stalls", m.branch_resolve.operand_stalls);
+    if (m.branch_resolve.ex_baseline_cpi > 0) {
+        add_f(out, "metrics.branch_resolve.ex_baseline_cpi", m.branch_resolve.ex_baseline_cpi);
+        add_f(out, "metrics.branch_resolve.cpi_gain_pct", 100.0 * (1.0 - m.cpi() / m.branch_resolve.ex_baseline_cpi));
+    }
+
+    add  (out, "metrics.activity.rf_reads", m.activity.rf_reads);
+    add  (out, "metrics.activity.rf_writes", m.activity.rf_writes);
+    add  (out, "metrics.activity.flushes", m.activity.flushes);
+
+    add  (out, "metrics.noc.requests", m.noc.requests);
+    add  (out, "metrics.noc.request_cycles", m.noc.request_cycles);
+    add_f(out, "metrics.noc.avg_round_trip", m.noc.avg_request_cycles());
+    add  (out, "metrics.noc.packets", m.noc.packets);
+    add  (out, "metrics.noc.packet_cycles", m.noc.packet_cycles);
+    add_f(out, "metrics.noc.avg_latency", m.noc.avg_packet_cycles());
+    add  (out, "metrics.noc.queue_cycles", m.noc.queue_cycles);
+    add  (out, "metrics.noc.hops", m.noc.hops);
+
+    add(out, "metrics.wrong_path.instructions", m.wrong_path.instructions);
+    add(out, "metrics.wrong_path.loads", m.wrong_path.loads);
+    add(out, "metrics.wrong_path.fills", m.wrong_path.fills);
+    add(out, "metrics.wrong_path.prefetch_hits", m.wrong_path.prefetch_hits);
+    add(out, "metrics.wrong_path.pollution_misses", m.wrong_path.pollution_misses);
+
+    add(out, "metrics.calls.calls", m.calls.calls);
+    add(out, "metrics.calls.returns", m.calls.returns);
+    add(out, "metrics.calls.ras_overflows", m.calls.ras_overflows);
+    add(out, "metrics.calls.ras_underflows", m.calls.ras_underflows);
+    add(out, "metrics.calls.return_mispredicts", m.calls.return_mispredicts);
+
+    add  (out, "metrics.fusion.pairs", m.fusion.pairs);
+    for (int r = 0; r < kNumFusionRules; ++r)
+        add(out, std::string("metrics.fusion.") + fusion_rule_name((FusionRule)r), m.fusion.by_rule[r]);
+    add_f(out, "metrics.fusion.rate_pct", m.fusion_rate_pct());
+    if (m.fusion.baseline_cpi > 0) {
+        add_f(out, "metrics.fusion.baseline_cpi", m.fusion.baseline_cpi);
+        add_f(out, "metrics.fusion.cpi_gain_pct", 100.0 * (1.0 - m.cpi() / m.fusion.baseline_cpi));
+    }
+
+    for (int p = 0; p < kNumBypassPaths; ++p) {
+        const std::string key = std::string("metrics.bypass.") + bypass_path_name((BypassPath)p);
+        add(out, key + ".used", m.bypass.used[p]);
+        add(out, key + ".missing_stalls", m.bypass.missing[p]);
+    }
+
+    add(out, "metrics.resources.mem_port", m.resources.mem_port);
+    add(out, "metrics.resources.rf_read", m.resources.rf_read);
+    add(out, "metrics.resources.rf_write", m.resources.rf_write);
+    add(out, "metrics.resources.divider", m.resources.divider);
+    add(out, "metrics.resources.divides", m.resources.divides);
+
+    add  (out, "metrics.frontend.fetches", m.frontend.fetches);
+    add  (out, "metrics.frontend.decodes", m.frontend.decodes);
+    add  (out, "metrics.frontend.uop_hits", m.frontend.uop_hits);
+    add  (out, "metrics.frontend.uop_misses", m.frontend.uop_misses);
+    add  (out, "metrics.frontend.uop_evictions", m.frontend.uop_evictions);
+    add  (out, "metrics.frontend.lsd_hits", m.frontend.lsd_hits);
+    add  (out, "metrics.frontend.lsd_locks", m.frontend.lsd_locks);
+    add  (out, "metrics.frontend.short_redirects", m.frontend.short_redirects);
+    add_f(out, "metrics.frontend.hit_rate_pct", m.frontend.hit_rate_pct());
+    add_f(out, "metrics.frontend.energy_pct", m.frontend.energy_pct());
+    add_f(out, "metrics.frontend.decode_duty_pct", m.decode_duty_pct());
+
+    for (int c = 0; c < kNumCpiComponents; ++c)
+        add(out, std::string("metrics.cpi_stack.") + cpi_component_name((CpiComponent)c), m.cpi_stack.cycles[c]);
+
+    if (m.convergence.enabled) {
+        const ConvergenceStats& c = m.convergence;
+        add  (out, "metrics.convergence.converged", c.converged ? 1 : 0);
+        add  (out, "metrics.convergence.at_cycle", c.at_cycle);
+        add  (out, "metrics.convergence.batches", c.batches);
+        add  (out, "metrics.convergence.batch_cycles", c.batch_cycles);
+        add_f(out, "metrics.convergence.cpi_mean", c.cpi_mean);
+        add_f(out, "metrics.convergence.cpi_halfwidth", c.cpi_halfwidth);
+        add_f(out, "metrics.convergence.mispredict_rate", c.mispredict_rate);
+        add_f(out, "metrics.convergence.mispredict_halfwidth", c.mispredict_halfwidth);
+    }
+
+    static const char* kStage[kNumTrackedStages] = {"IF", "ID", "EX", "MEM"};
+    auto hist = [&](const std::string& p, const LatencyHistogram& h) {
+        add(out, p + ".count", h.count());
+        add(out, p + ".p50", h.percentile(0.50));
+        add(out, p + ".p90", h.percentile(0.90));
+        add(out, p + ".p99", h.percentile(0.99));
+        add(out, p + ".max", h.max());
+    };
+    for (int c = 0; c < kNumOpClasses; ++c) {
+        if (m.latency.total[c].count() == 0) continue;
+        std::string p = std::string("metrics.latency.") + op_class_name((OpClass)c);
+        hist(p + ".total", m.latency.total[c]);
+        for (int s = 0; s < kNumTrackedStages; ++s) hist(p + "." + kStage[s], m.latency.stage[c][s]);
+    }
+}
+
+void append_predictor_fields(std::vector<ReportField>& out, const BranchPredictor& bp) {
+    add_s(out, "predictor.name", bp.name());
+    add  (out, "predictor.total_predictions", (uint64_t)bp.total_predictions);
+    add  (out, "predictor.mispredictions", (uint64_t)bp.mispredictions);
+    add_f(out, "predictor.accuracy_pct", bp.accuracy());
+}
+
+void append_energy_fields(std::vector<ReportField>& out, const RunInfo& run, const Metrics& m) {
+    const EnergyReport r = estimate_energy(run.energy, m);
+    for (int e = 0; e < kNumEnergyEvents; ++e) {
+        const std::string p = std::string("energy.events.") + energy_event_name((EnergyEvent)e);
+        add  (out, p + ".count", energy_event_count(m, (EnergyEvent)e));
+        add_f(out, p + ".pj", r.pj[e]);
+    }
+    add_f(out, "energy.total_pj", r.total_pj);
+    add_f(out, "energy.epi_pj", r.epi_pj);
+    add_f(out, "energy.seconds", r.seconds);
+    add_f(out, "energy.power_mw", r.power_mw);
+}
+
+void append_timing_fields(std::vector<ReportField>& out, const RunInfo& run, const Metrics& m) {
+    if (!run.timing.enabled) return;
+    const TimingPoint t = time_run(run.timing, run.pipeline, m);
+    add_f(out, "timing.period_ps", t.period_ps);
+    add_s(out, "timing.limiting_stage", pipe_stage_name(t.limit));
+    add_f(out, "timing.freq_ghz", 1000.0 / t.period_ps);
+    add_f(out, "timing.tpi_ps", t.tpi_ps);
+    add_f(out, "timing.seconds", t.seconds);
+    const std::vector<TimingPoint> sweep = sweep_depths(run.timing, run.pipeline, m);
+    if (sweep.empty()) return;
+    for (const TimingPoint& p : sweep) {
+        const std::string key = "timing.sweep." + std::to_string(p.depth);
+        add_f(out, key + ".period_ps", p.period_ps);
+        add_f(out, key + ".cpi", p.cpi);
+        add_f(out, key + ".tpi_ps", p.tpi_ps);
+    }
+    const TimingPoint& best = best_depth(sweep);
+    add  (out, "timing.best_depth", (uint64_t)best.depth);
+    add_f(out, "timing.best_tpi_ps", best.tpi_ps);
+}
+
+// Per-interval series as a table
+static std::vector<std::string> interval_columns() {
+    std::vector<std::string> cols = {"start_cycle", "cycles", "retired", "bp_predictions", "bp_mispredictions"};
+    for (int c = 0; c < kNumCpiComponents; ++c) cols.push_back(cpi_component_name((CpiComponent)c));
+    return cols;
+}
+static void interval_row(const IntervalSample& iv, std::vector<uint64_t>& row) {
+    row = {iv.start_cycle, iv.cycles, iv.retired, iv.bp_predictions, iv.bp_mispredictions};
+    for (uint64_t v : iv.cpi_stack.cycles) row.push_back(v);
+}
+
+// ------------------------------ JSON ------------------------------
+
+// Emits fields as members of the currently open object, nesting on '.'.
+// Fields sharing a prefix must be adjacent.
+static void write_fields_json(std::ostream& os, const std::vector<ReportField>& fields) {
+    std::vector<std::string> open;  // currently open nested objects
+    bool first = true;
+    for (const ReportField& f : fields) {
+        std::vector<std::string> parts;
+        size_t a = 0, b;
+        while ((b = f.name.find('.', a)) != std::string::npos) { parts.push_back(f.name.substr(a, b - a)); a = b + 1; }
+        std::string leaf = f.name.substr(a);
+
+        size_t common = 0;
+        while (common < open.size() && common < parts.size() && open[common] == parts[common]) ++common;
+        while (open.size() > common) { os << "}"; open.pop_back(); first = false; }
+        for (size_t i = common; i < parts.size(); ++i) {
+            if (!first) os << ",";
+            os << json_str(parts[i]) << ":{";
+            open.push_back(parts[i]);
+            first = true;
+        }
+        if (!first) os << ",";
+        os << json_str(leaf) << ":";
+        switch (f.kind) {
+            case ReportField::U64: os << f.u; break;
+            case ReportField::F64: json_num(os, f.d); break;
+            case ReportField::Str: os << json_str(f.s); break;
+        }
+        first = false;
+    }
+    while (!open.empty()) { os << "}"; open.pop_back(); }
+}
+
+static void write_host(std::ostream& os, const HostReport& host) {
+    os << "{\"requested\":" << (host.requested ? "true" : "false")
+       << ",\"available\":" << (host.available ? "true" : "false")
+       << ",\"error\":" << json_str(host.error)
+       << ",\"phases\":[";
+    for (size_t i = 0; i < host.phases.size(); ++i) {
+        const HostPhase& p = host.phases[i];
+        if (i) os << ",";
+        os << "{\"name\":" << json_str(p.name) << ",\"seconds\":" << p.seconds;
+        for (int c = 0; c < kNumHostCounters; ++c) {
+            os << ",\"" << host_counter_name((HostCounter)c) << "\":";
+            if (p.valid[c]) os << p.value[c]; else os << "null";
+        }
+        os << "}";
+    }
+    os << "]}";
+}
+
+void write_stats_json(std::ostream& os, const RunInfo& run, const Metrics& m,
+                      const HostReport& host) {
+    std::vector<ReportField> f;
+    append_run_fields(f, run);
+    append_metrics_fields(f, m);
+    append_energy_fields(f, run, m);
+    append_timing_fields(f, run, m);
+    os << "{";
+    write_fields_json(os, f);
+    os << ",\"host\":";
+    write_host(os, host);
+    os << "}\n";
+}
+
+void write_summary_json(std::ostream& os, const RunInfo& run, const Metrics& m,
+                        const BranchPredictor& bp, const std::vector<IntervalSample>& series) {
+    std::vector<ReportField> f;
+    append_run_fields(f, run);
+    append_predictor_fields(f, bp);
+    append_metrics_fields(f, m);
+    append_energy_fields(f, run, m);
+    append_timing_fields(f, run, m);
+    os << "{";
+    write_fields_json(os, f);
+
+    os << ",\"intervals\":{\"columns\":[";
+    auto cols = interval_columns();
+    for (size_t i = 0; i < cols.size(); ++i) os << (i ? "," : "") << json_str(cols[i]);
+    os << "],\"rows\":[";
+    std::vector<uint64_t> row;
+    for (size_t r = 0; r < series.size(); ++r) {
+        interval_row(series[r], row);
+        os << (r ? "," : "") << "[";
+        for (size_t i = 0; i < row.size(); ++i) os << (i ? "," : "") << row[i];
+        os << "]";
+    }
+    os << "]}}\n";
+}
+
+// ------------------------------ binary ------------------------------
+
+template <typename T>
+static void put_le(std::ostream& os, T v) {
+    for (size_t i = 0; i < sizeof(T); ++i) os.put((char)(((uint64_t)v >> (8 * i)) & 0xff));
+}
+
+void write_summary_bin(std::ostream& os, const RunInfo& run, const Metrics& m,
+                       const BranchPredictor& bp, const std::vector<IntervalSample>& series) {
+    std::vector<ReportField> fields;
+    append_run_fields(fields, run);
+    append_predictor_fields(fields, bp);
+    append_metrics_fields(fields, m);
+    append_energy_fields(fields, run, m);
+    append_timing_fields(fields, run, m);
+
+    os.write("CPUSIMS\1", 8);
+    put_le<uint32_t>(os, (uint32_t)fields.size());
+    for (const ReportField& f : fields) {
+        put_le<uint8_t>(os, f.kind);
+        put_le<uint16_t>(os, (uint16_t)f.name.size());
+        os.write(f.name.data(), (std::streamsize)f.name.size());
+        switch (f.kind) {
+            case ReportField::U64: put_le<uint64_t>(os, f.u); break;
+            case ReportField::F64: {
+                uint64_t bits;
+                static_assert(sizeof(bits) == sizeof(f.d), "double must be 64-bit");
+                std::memcpy(&bits, &f.d, sizeof(bits));
+                put_le<uint64_t>(os, bits);
+                break;
+            }
+            case ReportField::Str:
+                put_le<uint32_t>(os, (uint32_t)f.s.size());
+                os.write(f.s.data(), (std::streamsize)f.s.size());
+                break;
+        }
+    }
+
+    auto cols = interval_columns();
+    put_le<uint32_t>(os, (uint32_t)cols.size());
+    for (const auto& c : cols) {
+        put_le<uint16_t>(os, (uint16_t)c.size());
+        os.write(c.data(), (std::streamsize)c.size());
+    }
+    put_le<uint32_t>(os, (uint32_t)series.size());
+    std::vector<uint64_t> row;
+    for (const auto& iv : series) {
+        interval_row(iv, row);
+        for (uint64_t v : row) put_le<uint64_t>(os, v);
+    }
+}
+
+std::string summary_path(const std::string& timeline_csv, const std::string& ext) {
+    std::filesystem::path p(timeline_csv);
+    p.replace_extension(".summary" + ext);
+    return p.string();
+}
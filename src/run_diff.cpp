@@ -0,0 +1,179 @@
+#include "run_diff.hpp"
+#include <algorithm>
+#include <vector>
+
+// Field `col` of a comma-separated line (no quoting in timeline CSVs)
+static bool csv_field(const std::string& line, int col, std::string& out) {
+    size_t a = 0;
+    for (int i = 0; i < col; ++i) {
+        a = line.find(',', a);
+        if (a == std::string::npos) return false;
+        ++a;
+    }
+    size_t b = line.find(',', a);
+    out = line.substr(a, b == std::string::npos ? std::string::npos : b - a);
+    while (!out.empty() && (out.back() == '\r' || out.back() == ' ')) out.pop_back();
+    return true;
+}
+
+std::optional<std::string> RetireReader::open(const std::string& path) {
+    path_ = path;
+    in_.open(path);
+    if (!in_) return "Cannot open timeline: " + path;
+    if (!std::getline(in_, line_)) return path + ": empty file";
+
+    std::string h;
+    for (int c = 0; csv_field(line_, c, h); ++c)
+        if (h == "WB") wb_col_ = c;
+    if (wb_col_ < 0) return path + ": not a timeline CSV (no WB column)";
+    return std::nullopt;
+}
+
+bool RetireReader::next(RetireEvent& ev) {
+    if (has_tail_) {
+        has_tail_ = false;
+        ev = tail_;
+        return true;
+    }
+    std::string cell;
+    while (std::getline(in_, line_)) {
+        ++line_no_;
+        if (line_.empty() || line_ == "\r") continue;
+        try {
+            last_cycle_ = std::stoull(line_);
+        } catch (...) {
+            error_ = path_ + ":" + std::to_string(line_no_) + ": bad cycle number";
+            return false;
+        }
+        if (!csv_field(line_, wb_col_, cell) || cell.empty() || cell == "-") continue;
+
+        size_t hash = cell.find('#');
+        if (hash == std::string::npos) continue;
+        ev.cycle = last_cycle_;
+        ev.op = cell.substr(0, hash);
+        try {
+            ev.pc = std::stoi(cell.substr(hash + 1));
+        } catch (...) {
+            error_ = path_ + ":" + std::to_string(line_no_) + ": bad WB cell '" + cell + "'";
+            return false;
+        }
+        // A fused slot ("SUB+BEQ#4") retires its head and the next PC in the same cycle
+        const size_t plus = ev.op.find('+');
+        if (plus != std::string::npos) {
+            tail_ = { ev.cycle, ev.pc + 1, ev.op.substr(plus + 1) };
+            has_tail_ = true;
+            ev.op.resize(plus);
+        }
+        return true;
+    }
+    return false;
+}
+
+std::optional<std::string> diff_runs(const std::string& path_a, const std::string& path_b,
+                                     DiffResult& out, std::ostream* per_instr) {
+    RetireReader ra, rb;
+    if (auto err = ra.open(path_a)) return err;
+    if (auto err = rb.open(path_b)) return err;
+
+    out = DiffResult{};
+    if (per_instr) *per_instr << "index,pc,op,retire_a,retire_b,delta,local\n";
+
+    RetireEvent ea, eb;
+    int64_t prev_delta = 0;
+    bool has_a = ra.next(ea), has_b = rb.next(eb);
+    while (has_a && has_b) {
+        const uint64_t idx = out.aligned;
+        if (ea.pc != eb.pc) {
+            out.path_mismatch = true;
+            out.path_index = idx;
+            out.path_a = ea;
+            out.path_b = eb;
+            break;
+        }
+        const int64_t delta = (int64_t)eb.cycle - (int64_t)ea.cycle;
+        const int64_t local = delta - prev_delta;
+        prev_delta = delta;
+
+        if (delta != 0 && !out.diverged) {
+            out.diverged = true;
+            out.div_index = idx;
+            out.div_a = ea;
+            out.div_b = eb;
+        }
+        if (idx == 0) out.min_delta = out.max_delta = delta;
+        out.min_delta = std::min(out.min_delta, delta);
+        out.max_delta = std::max(out.max_delta, delta);
+        out.final_delta = delta;
+
+        PcDelta& pd = out.per_pc[ea.pc];
+        if (pd.op.empty()) pd.op = ea.op;
+        pd.count++;
+        pd.cycles += local;
+
+        if (per_instr)
+            *per_instr << idx << "," << ea.pc << "," << ea.op << "," << ea.cycle << ","
+                       << eb.cycle << "," << delta << "," << local << "\n";
+
+        out.aligned++;
+        has_a = ra.next(ea);
+        has_b = rb.next(eb);
+    }
+
+    // Drain both files: the tails are counted, and the run lengths need the last row
+    for (; has_a; has_a = ra.next(ea)) out.only_a++;
+    for (; has_b; has_b = rb.next(eb)) out.only_b++;
+    if (!ra.error().empty()) return ra.error();
+    if (!rb.error().empty()) return rb.error();
+
+    out.cycles_a = ra.last_cycle();
+    out.cycles_b = rb.last_cycle();
+    return std::nullopt;
+}
+
+void print_diff_report(std::ostream& os, const DiffResult& r, size_t top) {
+    os << "Cycles: A=" << r.cycles_a << " B=" << r.cycles_b
+       << " (B-A=" << (int64_t)r.cycles_b - (int64_t)r.cycles_a << ")\n";
+    os << "Aligned " << r.aligned << " dynamic instructions";
+    if (r.only_a || r.only_b) os << "; unmatched A=" << r.only_a << " B=" << r.only_b;
+    os << "\n";
+
+    if (r.path_mismatch)
+        os << "Paths differ at instruction " << r.path_index << ": A retired "
+           << r.path_a.op << "#" << r.path_a.pc << " @" << r.path_a.cycle << ", B retired "
+           << r.path_b.op << "#" << r.path_b.pc << " @" << r.path_b.cycle
+           << " (alignment stops here)\n";
+
+    if (!r.diverged) {
+        if (r.path_mismatch)
+            os << "No divergence before the paths differ: the " << r.aligned
+               << " aligned instructions retired in the same cycle\n";
+        else
+            os << "No divergence: every aligned instruction retired in the same cycle\n";
+        return;
+    }
+    os << "First divergence at instruction " << r.div_index << ": "
+       << r.div_a.op << "#" << r.div_a.pc << " retired @" << r.div_a.cycle << " in A, @"
+       << r.div_b.cycle << " in B\n";
+    os << "Retire delta (B-A): min=" << r.min_delta << " max=" << r.max_delta
+       << " final=" << r.final_delta << "\n";
+
+    std::vector<std::pair<int, PcDelta>> pcs(r.per_pc.begin(), r.per_pc.end());
+    auto list = [&](const char* title, bool slower) {
+        std::sort(pcs.begin(), pcs.end(), [&](const auto& x, const auto& y) {
+            if (x.second.cycles != y.second.cycles)
+                return slower ? x.second.cycles > y.second.cycles : x.second.cycles < y.second.cycles;
+            return x.first < y.first;
+        });
+        os << title << "\n";
+        size_t n = 0;
+        for (const auto& [pc, d] : pcs) {
+            if (n == top || (slower ? d.cycles <= 0 : d.cycles >= 0)) break;
+            os << "  PC " << pc << " " << d.op << ": " << (d.cycles > 0 ? "+" : "") << d.cycles
+               << " cycles over " << d.count << " instances\n";
+            ++n;
+        }
+        if (n == 0) os << "  (none)\n";
+    };
+    list("PCs where B lost most cycles:", true);
+    list("PCs where B gained most cycles:", false);
+}
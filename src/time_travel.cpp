@@ -0,0 +1,139 @@
+#include "time_travel.hpp"
+#include <algorithm>
+#include <sstream>
+#include <unordered_set>
+
+TimeTravel::TimeTravel(Pipeline& pipe, BranchPredictor* bp, uint64_t every, size_t budget_bytes)
+: pipe_(pipe), bp_(bp), every_(every ? every : 1), budget_(budget_bytes) {}
+
+void TimeTravel::record() {
+    const uint64_t now = pipe_.cycle();
+    if (!snaps_.empty() && now < snaps_.back().cycle + every_) return;
+
+    Snapshot s;
+    s.cycle = now;
+    std::ostringstream os;
+    pipe_.save_state(os, false);
+    s.pipe = os.str();
+
+    PredictorState cur;
+    if (bp_) {
+        s.bp_total = bp_->total_predictions;
+        s.bp_miss  = bp_->mispredictions;
+        bp_->save_state(cur);
+    }
+    pipe_.save_indirect_tables(cur, kIndirectTables);
+    std::sort(cur.begin(), cur.end());
+
+    // Delta against the current key frame: one merge pass over both sorted tables
+    std::shared_ptr<const PredictorState> base = snaps_.empty() ? nullptr : snaps_.back().base;
+    if (base && since_key_ < kMaxSinceKey) {
+        size_t i = 0, j = 0;
+        while (i < base->size() || j < cur.size()) {
+            if (j == cur.size() || (i < base->size() && (*base)[i].first < cur[j].first)) {
+                s.removed.push_back((*base)[i++].first);
+            } else if (i == base->size() || cur[j].first < (*base)[i].first) {
+                s.changed.push_back(cur[j++]);
+            } else {
+                if ((*base)[i].second != cur[j].second) s.changed.push_back(cur[j]);
+                ++i; ++j;
+            }
+        }
+        if (2 * (s.changed.size() + s.removed.size()) > cur.size()) base = nullptr;
+    } else {
+        base = nullptr;
+    }
+    if (base) {
+        s.base = base;
+        since_key_++;
+    } else {
+        s.changed.clear();
+        s.removed.clear();
+        s.base = std::make_shared<const PredictorState>(std::move(cur));
+        since_key_ = 0;
+    }
+    snaps_.push_back(std::move(s));
+    bytes_ = recount();
+    enforce_budget();
+}
+
+bool TimeTravel::restore(const Snapshot& s) {
+    // The whole blob must parse: a short or overlong one was saved for another config
+    std::istringstream is(s.pipe);
+    if (!pipe_.load_state(is, false) || is.peek() != std::char_traits<char>::eof()) return false;
+    if (bp_) {
+        bp_->total_predictions = s.bp_total;
+        bp_->mispredictions    = s.bp_miss;
+    }
+
+    PredictorState st;
+    if (s.base) st = *s.base;
+    // changed/removed are sorted; apply them with one merge pass
+    PredictorState out;
+    out.reserve(st.size() + s.changed.size());
+    size_t i = 0, j = 0, r = 0;
+    while (i < st.size() || j < s.changed.size()) {
+        if (j == s.changed.size() || (i < st.size() && st[i].first < s.changed[j].first)) {
+            while (r < s.removed.size() && s.removed[r] < st[i].first) ++r;
+            if (r == s.removed.size() || s.removed[r] != st[i].first) out.push_back(st[i]);
+            ++i;
+        } else {
+            if (i < st.size() && st[i].first == s.changed[j].first) ++i;
+            out.push_back(s.changed[j++]);
+        }
+    }
+    // Each side picks its own tables out of the merged state
+    if (bp_) bp_->load_state(out);
+    pipe_.load_indirect_tables(out, kIndirectTables);
+    return true;
+}
+
+bool TimeTravel::seek(uint64_t cycle) {
+    // Nearest snapshot at or before the target
+    auto it = std::upper_bound(snaps_.begin(), snaps_.end(), cycle,
+                               [](uint64_t c, const Snapshot& s) { return c < s.cycle; });
+    const bool have = it != snaps_.begin();
+    const uint64_t snap_cycle = have ? std::prev(it)->cycle : 0;
+
+    // Stepping on from where we are beats restoring an older snapshot
+    if (pipe_.cycle() > cycle || !have || snap_cycle > pipe_.cycle()) {
+        if (!have || !restore(*std::prev(it))) return false;
+    }
+    while (pipe_.cycle() < cycle && !pipe_.halted()) {
+        pipe_.step();
+        record();
+    }
+    return pipe_.cycle() == cycle;
+}
+
+bool TimeTravel::step_back() {
+    if (pipe_.cycle() == 0) return false;
+    return seek(pipe_.cycle() - 1);
+}
+
+size_t TimeTravel::recount() const {
+    size_t n = snaps_.capacity() * sizeof(Snapshot);
+    std::unordered_set<const PredictorState*> bases;
+    for (const Snapshot& s : snaps_) {
+        n += s.pipe.capacity()
+           + s.changed.capacity() * sizeof(PredictorState::value_type)
+           + s.removed.capacity() * sizeof(uint64_t);
+        if (s.base && bases.insert(s.base.get()).second)
+            n += s.base->capacity() * sizeof(PredictorState::value_type);
+    }
+    return n;
+}
+
+void TimeTravel::enforce_budget() {
+    while (bytes_ > budget_ && snaps_.size() > 2) {
+        // Keep snapshots 0, 2, 4, ... and the newest; key frames shared by
+        // survivors stay alive through their shared_ptr.
+        std::vector<Snapshot> kept;
+        kept.reserve(snaps_.size() / 2 + 1);
+        for (size_t i = 0; i < snaps_.size(); ++i)
+            if (i % 2 == 0 || i + 1 == snaps_.size()) kept.push_back(std::move(snaps_[i]));
+        snaps_.swap(kept);
+        every_ *= 2;
+        bytes_ = recount();
+    }
+}
@@ -0,0 +1,87 @@
+#include "timing.hpp"
+#include "file_io.hpp"
+#include <algorithm>
+
+std::optional<std::string> load_timing_model(const std::string& path, TimingModel& out) {
+    return load_key_values(path, "timing model", [&](const std::string& key, double v) -> std::optional<std::string> {
+        if (key == "latch") {
+            if (v <= 0.0) return "latch must be positive";
+            out.latch_ps = v;
+            return std::nullopt;
+        }
+        int s = 0;
+        while (s < kNumPipeStages && key != pipe_stage_name((PipeStage)s)) ++s;
+        if (s == kNumPipeStages) return "unknown stage '" + key + "'";
+        out.logic_ps[s] = v;
+        return std::nullopt;
+    });
+}
+
+static double piece_ps(const TimingModel& t, const StageSplit& s, int stage) {
+    return t.logic_ps[stage] / (double)s.pieces[stage];
+}
+
+StageSplit split_for_depth(const TimingModel& t, int depth) {
+    StageSplit s;
+    for (int d = s.depth(); d < depth; ++d) {
+        int slowest = 0;
+        for (int i = 1; i < kNumPipeStages; ++i)
+            if (piece_ps(t, s, i) > piece_ps(t, s, slowest)) slowest = i;
+        s.pieces[slowest]++;
+    }
+    return s;
+}
+
+PipeStage limiting_stage(const TimingModel& t, const StageSplit& s) {
+    int slowest = 0;
+    for (int i = 1; i < kNumPipeStages; ++i)
+        if (piece_ps(t, s, i) > piece_ps(t, s, slowest)) slowest = i;
+    return (PipeStage)slowest;
+}
+
+double clock_period_ps(const TimingModel& t, const StageSplit& s) {
+    return piece_ps(t, s, (int)limiting_stage(t, s)) + t.latch_ps;
+}
+
+TimingPoint time_run(const TimingModel& t, const PipelineConfig& cfg, const Metrics& m, int depth) {
+    TimingPoint p;
+    p.depth = depth;
+    p.split = split_for_depth(t, depth);
+    p.period_ps = clock_period_ps(t, p.split);
+    p.limit = limiting_stage(t, p.split);
+
+    // Penalty of each component in stages, relative to the 5-stage pipe it was measured on
+    auto k = [&](PipeStage st) { return (double)p.split.pieces[(int)st]; };
+    const bool id_resolve = cfg.branch_resolve == BranchResolve::Id;
+    const double control = id_resolve ? k(PipeStage::IF) + k(PipeStage::ID) - 1.0
+                                      : (k(PipeStage::IF) + k(PipeStage::ID) + k(PipeStage::EX) - 1.0) / 2.0;
+    const double load_use = k(PipeStage::EX) + k(PipeStage::MEM) - 1.0;
+    const double raw = (k(PipeStage::EX) + k(PipeStage::MEM) + k(PipeStage::WB) - 1.0) / 2.0;
+    const double in_ns = clock_period_ps(t, StageSplit{}) / p.period_ps;
+    const double divider = m.stalls.structural
+        ? std::min(1.0, (double)m.resources.divider / (double)m.stalls.structural) : 0.0;
+    const double structural = 1.0 - divider + divider * in_ns;
+
+    const CpiStack& c = m.cpi_stack;
+    p.cycles = (double)c[CpiComponent::Base] + structural * (double)c[CpiComponent::Structural] +
+               control * (double)c[CpiComponent::Control] + load_use * (double)c[CpiComponent::LoadUse] +
+               raw * (double)c[CpiComponent::Raw] +
+               in_ns * (double)(c[CpiComponent::Fetch] + c[CpiComponent::Memory]);
+    p.cpi = m.retired ? p.cycles / (double)m.retired : 0.0;
+    p.tpi_ps = p.cpi * p.period_ps;
+    p.seconds = p.cycles * p.period_ps * 1e-12;
+    return p;
+}
+
+std::vector<TimingPoint> sweep_depths(const TimingModel& t, const PipelineConfig& cfg, const Metrics& m) {
+    std::vector<TimingPoint> out;
+    for (int d = kNumPipeStages; d <= t.sweep_depth; ++d) out.push_back(time_run(t, cfg, m, d));
+    return out;
+}
+
+const TimingPoint& best_depth(const std::vector<TimingPoint>& sweep) {
+    size_t best = 0;
+    for (size_t i = 1; i < sweep.size(); ++i)
+        if (sweep[i].tpi_ps < sweep[best].tpi_ps) best = i;
+    return sweep[best];
+}
@@ -1,15 +1,10 @@
 #include "trace_loader.hpp"
+#include "file_io.hpp"
 #include <fstream>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
-
-static std::string trim(const std::string& s) {
-    size_t a = s.find_first_not_of(" \t\r\n");
-    if (a == std::string::npos) return "";
-    size_t b = s.find_last_not_of(" \t\r\n");
-    return s.substr(a, b - a + 1);
-}
+#include <climits>
 
 static std::string upper(std::string s) {
     std::transform(s.begin(), s.end(), s.begin(),
@@ -44,6 +39,9 @@ std::string opcode_name(Opcode op) {
         case Opcode::BNE:   return "BNE";
         case Opcode::NOP:   return "NOP";
         case Opcode::HALT:  return "HALT";
+        case Opcode::JAL:   return "JAL";
+        case Opcode::JALR:  return "JALR";
+        case Opcode::DIV:   return "DIV";
     }
     return "UNK";
 }
@@ -54,6 +52,7 @@ std::string Instruction::to_string() const {
     switch (op) {
         case Opcode::ADD:
         case Opcode::SUB:
+        case Opcode::DIV:
             oss << " r" << rd << " r" << rs1 << " r" << rs2; break;
         case Opcode::LOAD:
             oss << " r" << rd << " [r" << rs1 << (imm>=0?"+":"") << imm << "]"; break;
@@ -62,6 +61,10 @@ std::string Instruction::to_string() const {
         case Opcode::BEQ:
         case Opcode::BNE:
             oss << " r" << rs1 << " r" << rs2 << " " << imm; break;
+        case Opcode::JAL:
+            oss << " r" << rd << " " << imm; break;
+        case Opcode::JALR:
+            oss << " r" << rd << " r" << rs1 << " " << imm; break;
         case Opcode::NOP:
         case Opcode::HALT:
             break;
@@ -69,37 +72,105 @@ std::string Instruction::to_string() const {
     return oss.str();
 }
 
-static bool parse_mem_operand(const std::string& tok, int& baseReg, int& imm) {
-    // format: [rX+imm] or [rX-imm] or [rX]
+// Register token, possibly templated on a loop variable: r{i}, r{i+3}, r{i-1}.
+// vars[d] is the name of the loop variable at nesting depth d ("" if unnamed).
+static bool parse_reg_ref(const std::string& tok, const std::vector<std::string>& vars,
+                          int& reg_out, int& var_out) {
+    var_out = -1;
+    size_t lb = tok.find('{');
+    if (lb == std::string::npos) return parse_reg(tok, reg_out);
+
+    if (lb != 1 || tok.back() != '}') return false;
+    std::string inner = tok.substr(2, tok.size() - 3);
+    size_t sep = inner.find_first_of("+-");
+    std::string name = inner.substr(0, sep);
+    int k = 0;
+    if (sep != std::string::npos) {
+        try { k = std::stoi(inner.substr(sep)); } catch (...) { return false; }
+    }
+    for (int d = (int)vars.size() - 1; d >= 0; --d) {
+        if (!name.empty() && vars[d] == name) {
+            var_out = d;
+            reg_out = ((k % kNumRegs) + kNumRegs) % kNumRegs;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_mem_operand(const std::string& tok, const std::vector<std::string>& vars,
+                              int& baseReg, int& baseVar, int& imm) {
+    // format: [rX+imm] or [rX-imm] or [rX]; rX may be a template such as r{i+1}
     if (tok.size() < 3 || tok.front() != '[' || tok.back() != ']') return false;
     std::string inner = tok.substr(1, tok.size()-2);
-    // find + or - if present
-    size_t plus = inner.find('+');
-    size_t minus = inner.find('-');
-    if (plus == std::string::npos && minus == std::string::npos) {
+    // find + or - if present (after the template braces, if any)
+    size_t close = inner.find('}');
+    size_t sep = inner.find_first_of("+-", close == std::string::npos ? 0 : close);
+    if (sep == std::string::npos) {
         // just [rX]
-        if (!parse_reg(inner, baseReg)) return false;
+        if (!parse_reg_ref(inner, vars, baseReg, baseVar)) return false;
         imm = 0; return true;
     }
-    size_t sep = (plus != std::string::npos ? plus : minus);
-    std::string lhs = inner.substr(0, sep);
-    std::string rhs = inner.substr(sep);
-    if (!parse_reg(lhs, baseReg)) return false;
-    try { imm = std::stoi(rhs); } catch (...) { return false; }
+    if (!parse_reg_ref(inner.substr(0, sep), vars, baseReg, baseVar)) return false;
+    try { imm = std::stoi(inner.substr(sep)); } catch (...) { return false; }
     return true;
 }
 
+// --------------------------- REPEAT expansion ---------------------------
+
+Instruction TraceProgram::at(int pc) const {
+    int iter[kMaxRepeatDepth] = {};
+    long long off = pc;
+    int n = 0;
+    for (;;) {
+        const Node& b = nodes_[n];
+        if (b.depth >= 0) {
+            iter[b.depth] = (int)(off / b.body_len);
+            off %= b.body_len;
+        }
+        // last kid whose offset is <= off
+        auto it = std::upper_bound(b.kid_off.begin(), b.kid_off.end(), off);
+        size_t k = (size_t)(it - b.kid_off.begin()) - 1;
+        off -= b.kid_off[k];
+        n = b.kids[k];
+
+        const Node& c = nodes_[n];
+        if (c.count > 0) continue;
+
+        auto rename = [&](const RegRef& r) {
+            return r.var < 0 ? r.reg : (r.reg + iter[r.var]) % kNumRegs;
+        };
+        Instruction ins = c.ins;
+        ins.rd  = rename(c.rd);
+        ins.rs1 = rename(c.rs1);
+        ins.rs2 = rename(c.rs2);
+        ins.id  = pc;
+        ins.pc  = pc;
+        return ins;
+    }
+}
+
 std::optional<std::string> load_trace(
     const std::string& path,
-    std::vector<Instruction>& out)
+    TraceProgram& out)
 {
     std::ifstream in(path);
     if (!in) return std::string("Could not open trace: ") + path;
 
-    out.clear();
+    out.nodes_.clear();
+    out.nodes_.emplace_back();          // root block
+    out.nodes_[0].count = 1;
+    out.size_ = 0;
+
+    std::vector<int> open = {0};        // stack of open block nodes
+    std::vector<std::string> vars;      // loop variable name per depth
     std::string line;
-    int pc = 0;
-    int nextId = 0;
+
+    // Appends node `idx` to the innermost open block
+    auto attach = [&](int idx) {
+        auto& parent = out.nodes_[open.back()];
+        parent.kids.push_back(idx);
+    };
 
     while (std::getline(in, line)) {
         // strip comments beginning with '#'
@@ -113,35 +184,84 @@ std::optional<std::string> load_trace(
         iss >> opTok;
         opTok = upper(opTok);
 
-        Instruction ins;
-        ins.id = nextId++;
-        ins.pc = pc++;
+        if (opTok == "REPEAT") {
+            std::string countTok, a, b;
+            if (!(iss >> countTok >> a)) return "Bad REPEAT at line: " + line;
+            std::string var;
+            if (a != "{") {
+                var = a;
+                if (!(iss >> b) || b != "{") return "REPEAT expects '{' at line: " + line;
+            }
+            if ((int)vars.size() >= kMaxRepeatDepth) return "REPEAT nested too deep at line: " + line;
+            TraceProgram::Node blk;
+            try { blk.count = std::stoi(countTok); } catch (...) { return "Bad REPEAT count at line: " + line; }
+            if (blk.count <= 0) return "Bad REPEAT count at line: " + line;
+            blk.depth = (int)vars.size();
+            out.nodes_.push_back(std::move(blk));
+            int idx = (int)out.nodes_.size() - 1;
+            attach(idx);
+            open.push_back(idx);
+            vars.push_back(var);
+            continue;
+        }
+        if (opTok == "}") {
+            if (open.size() < 2) return "Unmatched '}' at line: " + line;
+            if (out.nodes_[open.back()].kids.empty()) return "Empty REPEAT body at line: " + line;
+            open.pop_back();
+            vars.pop_back();
+            continue;
+        }
+
+        TraceProgram::Node node;
+        Instruction& ins = node.ins;
 
-        if (opTok == "ADD" || opTok == "SUB") {
+        if (opTok == "ADD" || opTok == "SUB" || opTok == "DIV") {
             std::string rd, rs1, rs2;
-            if (!(iss >> rd >> rs1 >> rs2)) return "Bad ADD/SUB at line: " + line;
-            if (!parse_reg(rd, ins.rd) || !parse_reg(rs1, ins.rs1) || !parse_reg(rs2, ins.rs2))
-                return "Bad register in ADD/SUB at line: " + line;
-            ins.op = (opTok == "ADD") ? Opcode::ADD : Opcode::SUB;
+            if (!(iss >> rd >> rs1 >> rs2)) return "Bad " + opTok + " at line: " + line;
+            if (!parse_reg_ref(rd, vars, node.rd.reg, node.rd.var) ||
+                !parse_reg_ref(rs1, vars, node.rs1.reg, node.rs1.var) ||
+                !parse_reg_ref(rs2, vars, node.rs2.reg, node.rs2.var))
+                return "Bad register in " + opTok + " at line: " + line;
+            ins.op = (opTok == "ADD") ? Opcode::ADD : (opTok == "SUB") ? Opcode::SUB : Opcode::DIV;
         } else if (opTok == "LOAD") {
             std::string rd, mem;
             if (!(iss >> rd >> mem)) return "Bad LOAD at line: " + line;
-            if (!parse_reg(rd, ins.rd)) return "Bad dest reg in LOAD at line: " + line;
-            if (!parse_mem_operand(mem, ins.rs1, ins.imm)) return "Bad mem operand in LOAD at line: " + line;
+            if (!parse_reg_ref(rd, vars, node.rd.reg, node.rd.var)) return "Bad dest reg in LOAD at line: " + line;
+            if (!parse_mem_operand(mem, vars, node.rs1.reg, node.rs1.var, ins.imm))
+                return "Bad mem operand in LOAD at line: " + line;
             ins.op = Opcode::LOAD;
         } else if (opTok == "STORE") {
             std::string rs2, mem;
             if (!(iss >> rs2 >> mem)) return "Bad STORE at line: " + line;
-            if (!parse_reg(rs2, ins.rs2)) return "Bad src reg in STORE at line: " + line;
-            if (!parse_mem_operand(mem, ins.rs1, ins.imm)) return "Bad mem operand in STORE at line: " + line;
+            if (!parse_reg_ref(rs2, vars, node.rs2.reg, node.rs2.var)) return "Bad src reg in STORE at line: " + line;
+            if (!parse_mem_operand(mem, vars, node.rs1.reg, node.rs1.var, ins.imm))
+                return "Bad mem operand in STORE at line: " + line;
             ins.op = Opcode::STORE;
         } else if (opTok == "BEQ" || opTok == "BNE") {
             std::string rs1, rs2, immTok;
             if (!(iss >> rs1 >> rs2 >> immTok)) return "Bad BEQ/BNE at line: " + line;
-            if (!parse_reg(rs1, ins.rs1) || !parse_reg(rs2, ins.rs2))
+            if (!parse_reg_ref(rs1, vars, node.rs1.reg, node.rs1.var) ||
+                !parse_reg_ref(rs2, vars, node.rs2.reg, node.rs2.var))
                 return "Bad reg in BEQ/BNE at line: " + line;
             try { ins.imm = std::stoi(immTok); } catch (...) { return "Bad imm in BEQ/BNE at line: " + line; }
             ins.op = (opTok == "BEQ") ? Opcode::BEQ : Opcode::BNE;
+        } else if (opTok == "JAL") {
+            std::string rd, immTok;
+            if (!(iss >> rd >> immTok)) return "Bad JAL at line: " + line;
+            if (!parse_reg_ref(rd, vars, node.rd.reg, node.rd.var)) return "Bad reg in JAL at line: " + line;
+            try { ins.imm = std::stoi(immTok); } catch (...) { return "Bad imm in JAL at line: " + line; }
+            ins.op = Opcode::JAL;
+        } else if (opTok == "JALR") {
+            // JALR rd rs1 [imm]
+            std::string rd, rs1, immTok;
+            if (!(iss >> rd >> rs1)) return "Bad JALR at line: " + line;
+            if (!parse_reg_ref(rd, vars, node.rd.reg, node.rd.var) ||
+                !parse_reg_ref(rs1, vars, node.rs1.reg, node.rs1.var))
+                return "Bad reg in JALR at line: " + line;
+            if (iss >> immTok) {
+                try { ins.imm = std::stoi(immTok); } catch (...) { return "Bad imm in JALR at line: " + line; }
+            }
+            ins.op = Opcode::JALR;
         } else if (opTok == "NOP") {
             ins.op = Opcode::NOP;
         } else if (opTok == "HALT") {
@@ -150,7 +270,38 @@ std::optional<std::string> load_trace(
             return "Unknown opcode: " + opTok;
         }
 
-        out.push_back(ins);
+        out.nodes_.push_back(std::move(node));
+        attach((int)out.nodes_.size() - 1);
+    }
+    if (open.size() > 1) return std::string("Unterminated REPEAT block in: ") + path;
+
+    // Expanded lengths, innermost blocks first (children always follow their parent)
+    for (int n = (int)out.nodes_.size() - 1; n >= 0; --n) {
+        auto& b = out.nodes_[n];
+        if (b.count == 0) continue;
+        long long len = 0;
+        b.kid_off.clear();
+        for (int k : b.kids) {
+            b.kid_off.push_back(len);
+            const auto& c = out.nodes_[k];
+            len += (c.count == 0) ? 1 : c.body_len * c.count;
+            if (len > INT_MAX) return std::string("Expanded trace too long (> INT_MAX instructions): ") + path;
+        }
+        b.body_len = len;
     }
+    if (out.nodes_[0].kids.empty()) return std::nullopt; // empty trace
+    out.size_ = (int)out.nodes_[0].body_len;
     return std::nullopt; // success
 }
+
+std::optional<std::string> load_trace(
+    const std::string& path,
+    std::vector<Instruction>& out)
+{
+    TraceProgram prog;
+    if (auto err = load_trace(path, prog)) return err;
+    out.clear();
+    out.reserve(prog.size());
+    for (int pc = 0; pc < prog.size(); ++pc) out.push_back(prog.at(pc));
+    return std::nullopt;
+}
@@ -39,12 +39,13 @@ function stageClass(value) {
       " bg-red-700/60 text-red-100 font-semibold ring-1 ring-red-500/40"
     );
 
-  // Instruction colors
+  // Instruction colors (a fused slot takes its first opcode's, with a ring)
+  if (value.includes("+")) return stageClass(value.replace(/\+[A-Z]+/, "")) + " ring-1 ring-inset ring-cyan-300/70";
   if (value.startsWith("LOAD") || value.startsWith("STORE"))
     return base + " bg-blue-700/40 text-blue-50";
-  if (value.startsWith("ADD") || value.startsWith("SUB"))
+  if (value.startsWith("ADD") || value.startsWith("SUB") || value.startsWith("DIV"))
     return base + " bg-emerald-700/40 text-emerald-50";
-  if (value.startsWith("BEQ") || value.startsWith("BNE"))
+  if (value.startsWith("BEQ") || value.startsWith("BNE") || value.startsWith("JAL"))
     return base + " bg-amber-700/40 text-amber-50";
   if (value.startsWith("HALT"))
     return base + " bg-violet-700/40 text-violet-50";
@@ -61,7 +62,7 @@ function deriveMetricsFromTimeline(tl) {
       cycles: 0,
       retired: 0,
       cpi: 0,
-      stalls: { total: 0, raw: 0, war: 0, waw: 0, ctrl: 0 },
+      stalls: { total: 0, raw: 0, war: 0, waw: 0, ctrl: 0, mem: 0 },
     };
   const idxWB = tl.header.findIndex((h) => h.toUpperCase() === "WB");
   const cycles = tl.rows.length;
@@ -71,13 +72,14 @@ function deriveMetricsFromTimeline(tl) {
     stallWAR = 0,
     stallWAW = 0,
     stallCTRL = 0,
+    stallMEM = 0,
     stallTotal = 0;
 
   for (const r of tl.rows) {
     if (idxWB >= 0) {
       const wb = r[idxWB];
       if (wb && wb !== "-" && !wb.startsWith("NOP") && !wb.startsWith("HALT"))
-        retired++;
+        retired += wb.split("#")[0].split("+").length; // fused slots ("SUB+BEQ#4") retire two
     }
     for (const cell of r) {
       if (isStallCell(cell)) {
@@ -86,6 +88,7 @@ function deriveMetricsFromTimeline(tl) {
         else if (cell.startsWith("STALL_WAR")) stallWAR++;
         else if (cell.startsWith("STALL_WAW")) stallWAW++;
         else if (cell.startsWith("STALL_CTRL")) stallCTRL++;
+        else if (cell.startsWith("STALL_SB") || cell.startsWith("STALL_STLF") || cell.startsWith("STALL_DCACHE") || cell.startsWith("STALL_DTLB")) stallMEM++;
       }
     }
   }
@@ -95,10 +98,221 @@ function deriveMetricsFromTimeline(tl) {
     cycles,
     retired,
     cpi,
-    stalls: { total: stallTotal, raw: stallRAW, war: stallWAR, waw: stallWAW, ctrl: stallCTRL },
+    stalls: { total: stallTotal, raw: stallRAW, war: stallWAR, waw: stallWAW, ctrl: stallCTRL, mem: stallMEM },
   };
 }
 
+// --- CPI stack (from `cpu-sim --cpi-stack out.csv`) ---
+const CPI_COMPONENTS = [
+  { key: "base", label: "Base", color: "bg-emerald-500" },
+  { key: "raw", label: "RAW", color: "bg-red-500" },
+  { key: "load_use", label: "Load-use", color: "bg-orange-500" },
+  { key: "control", label: "Control", color: "bg-amber-400" },
+  { key: "fetch", label: "Fetch", color: "bg-sky-500" },
+  { key: "structural", label: "Structural", color: "bg-fuchsia-500" },
+  { key: "memory", label: "Memory", color: "bg-blue-600" },
+];
+
+function parseCpiStack(tl) {
+  if (!tl) return [];
+  const col = Object.fromEntries(tl.header.map((h, i) => [h, i]));
+  return tl.rows.map((r) => {
+    const row = { start: Number(r[col.start_cycle] || 0), cycles: Number(r[col.cycles] || 0) };
+    for (const c of CPI_COMPONENTS) row[c.key] = Number(r[col[c.key]] || 0);
+    return row;
+  });
+}
+
+// --- Summary sidecar (x.summary.json, written next to every timeline CSV) ---
+// Carries exact metrics and the interval series, so nothing has to be rescanned.
+function metricsFromSummary(sum) {
+  const m = sum.metrics || {};
+  const st = m.stalls || {};
+  return {
+    cycles: m.cycles || 0,
+    retired: m.retired || 0,
+    cpi: m.cpi || 0,
+    stalls: {
+      total: st.total || 0,
+      raw: st.raw || 0,
+      war: st.war || 0,
+      waw: st.waw || 0,
+      ctrl: st.control || 0,
+      mem: (st.sb_full || 0) + (st.stlf_partial || 0) + (st.dcache_miss || 0) + (st.dtlb_miss || 0),
+    },
+  };
+}
+
+function cpiStackFromSummary(sum) {
+  const iv = sum.intervals;
+  if (!iv || !iv.rows) return [];
+  return parseCpiStack({ header: iv.columns, rows: iv.rows });
+}
+
+function CpiStackChart({ series }) {
+  if (!series.length) return null;
+  const total = Object.fromEntries(
+    CPI_COMPONENTS.map((c) => [c.key, series.reduce((s, r) => s + r[c.key], 0)])
+  );
+  const cycles = series.reduce((s, r) => s + r.cycles, 0) || 1;
+  const Bar = ({ row, denom, className }) => (
+    <div className={`flex ${className}`}>
+      {CPI_COMPONENTS.map((c) =>
+        row[c.key] ? (
+          <div
+            key={c.key}
+            className={c.color}
+            style={{ flexGrow: row[c.key] / denom, flexBasis: 0 }}
+            title={`${c.label}: ${row[c.key]}`}
+          />
+        ) : null
+      )}
+    </div>
+  );
+
+  return (
+    <div className="rounded-xl border border-slate-700 bg-slate-800/80 p-4 shadow-sm">
+      <div className="text-sm mb-2 text-slate-200">CPI stack ({cycles} cycles)</div>
+      <Bar row={total} denom={cycles} className="h-4 rounded overflow-hidden" />
+      {series.length > 1 && (
+        <div className="flex items-end gap-px h-24 mt-3">
+          {series.map((r, i) => (
+            <div key={i} className="flex-1 h-full" title={`@${r.start}`}>
+              <Bar row={r} denom={r.cycles || 1} className="flex-col-reverse h-full" />
+            </div>
+          ))}
+        </div>
+      )}
+      <div className="flex flex-wrap gap-3 mt-2 text-xs text-slate-300">
+        {CPI_COMPONENTS.map((c) => (
+          <span key={c.key} className="flex items-center gap-1">
+            <span className={`inline-block w-2 h-2 rounded-sm ${c.color}`} />
+            {c.label} {((100 * total[c.key]) / cycles).toFixed(1)}%
+          </span>
+        ))}
+      </div>
+    </div>
+  );
+}
+
+// ------------------------------ Live stream (cpu-sim --serve-live) ----------
+// Binary frames (little-endian), see include/live_server.hpp:
+//   1 = rows, 2 = interval metrics, 3 = done
+const OPCODES = ["ADD", "SUB", "LOAD", "STORE", "BEQ", "BNE", "NOP", "HALT", "JAL", "JALR", "DIV"];
+const STALL_LABELS = { raw: "STALL_RAW", load_use: "STALL_RAW", control: "STALL_CTRL" };
+const LIVE_MAX_ROWS = 2000; // rolling window kept on screen
+
+function liveCell(kind, code, id) {
+  if (kind === 1) return `${OPCODES[code] ?? "OP" + code}#${id}`;
+  if (kind === 2) {
+    const name = CPI_COMPONENTS[code]?.key ?? "stall";
+    return STALL_LABELS[name] ?? `STALL_${name.toUpperCase()}`;
+  }
+  return "-";
+}
+
+function decodeLiveFrame(buf) {
+  const dv = new DataView(buf);
+  const type = dv.getUint8(0);
+  if (type === 1) {
+    const n = dv.getUint16(2, true);
+    const stride = dv.getUint32(4, true);
+    const rows = [];
+    let off = 8;
+    for (let i = 0; i < n; i++) {
+      const row = [String(Number(dv.getBigUint64(off, true)))];
+      off += 8;
+      for (let c = 0; c < 5; c++) {
+        row.push(liveCell(dv.getUint8(off), dv.getUint8(off + 1), dv.getInt32(off + 2, true)));
+        off += 6;
+      }
+      rows.push(row);
+    }
+    return { type: "rows", rows, stride };
+  }
+  if (type === 2) {
+    const u = (i) => Number(dv.getBigUint64(8 + 8 * i, true));
+    const iv = { start: u(0), cycles: u(1), retired: u(2), bpPred: u(3), bpMiss: u(4) };
+    CPI_COMPONENTS.forEach((c, i) => (iv[c.key] = u(5 + i)));
+    return { type: "interval", iv };
+  }
+  if (type === 3) {
+    return { type: "done", dropped: Number(dv.getBigUint64(8, true)), sampledOut: Number(dv.getBigUint64(16, true)) };
+  }
+  return { type: "unknown" };
+}
+
+function LiveControls({ setTimeline, setFileName, setCpiStack }) {
+  const [port, setPort] = useState("8765");
+  const [status, setStatus] = useState("idle");
+  const [info, setInfo] = useState(null);
+  const wsRef = useRef(null);
+
+  useEffect(() => () => wsRef.current && wsRef.current.close(), []);
+
+  const connect = () => {
+    wsRef.current && wsRef.current.close();
+    const ws = new WebSocket(`ws://127.0.0.1:${port}`);
+    ws.binaryType = "arraybuffer";
+    wsRef.current = ws;
+    let rows = [];
+    let series = [];
+    let pending = false;
+    const flush = () => {
+      pending = false;
+      setTimeline({ header: ["cycle", "IF", "ID", "EX", "MEM", "WB"], rows: rows.slice() });
+      setCpiStack(series.slice());
+    };
+    ws.onopen = () => {
+      setStatus("live");
+      setFileName(`live @ ${port}`);
+    };
+    ws.onclose = () => setStatus((s) => (s === "done" ? s : "closed"));
+    ws.onerror = () => setStatus("error");
+    ws.onmessage = (ev) => {
+      const msg = decodeLiveFrame(ev.data);
+      if (msg.type === "rows") {
+        rows = rows.concat(msg.rows);
+        if (rows.length > LIVE_MAX_ROWS) rows = rows.slice(rows.length - LIVE_MAX_ROWS);
+        setInfo((i) => ({ ...i, stride: msg.stride, cycle: msg.rows[msg.rows.length - 1]?.[0] }));
+      } else if (msg.type === "interval") {
+        series = series.concat([msg.iv]);
+      } else if (msg.type === "done") {
+        setStatus("done");
+        setInfo((i) => ({ ...i, dropped: msg.dropped, sampledOut: msg.sampledOut }));
+      }
+      // batch React updates to one per animation frame
+      if (!pending) {
+        pending = true;
+        requestAnimationFrame(flush);
+      }
+    };
+  };
+
+  return (
+    <div className="flex items-center gap-2 text-sm text-slate-300">
+      <span>Live port</span>
+      <input
+        className="w-20 border border-slate-600 rounded-md px-2 py-1 bg-slate-800 text-slate-100"
+        value={port}
+        onChange={(e) => setPort(e.target.value)}
+      />
+      <button
+        className="px-3 py-1.5 rounded-md bg-slate-800 border border-slate-600 hover:bg-slate-700 text-slate-100 shadow-sm"
+        onClick={connect}
+      >
+        Connect
+      </button>
+      <span className="text-xs text-slate-400">
+        {status}
+        {info?.cycle ? ` · cycle ${info.cycle}` : ""}
+        {info?.stride > 1 ? ` · sampling 1/${info.stride}` : ""}
+        {info?.sampledOut ? ` · ${info.sampledOut} rows sampled out` : ""}
+      </span>
+    </div>
+  );
+}
+
 // ------------------------------ PNG export (lazy import) ------------------
 let html2canvasPromise = null;
 async function getHtml2Canvas() {
@@ -127,13 +341,13 @@ function StatCard({ title, value, note }) {
   );
 }
 
-function FilePicker({ label, onFile, onName }) {
+function FilePicker({ label, onFile, onName, accept = ".csv,.txt" }) {
   return (
     <label className="px-3 py-1.5 rounded-md bg-slate-800 border border-slate-600 hover:bg-slate-700 cursor-pointer text-sm text-slate-100 shadow-sm">
       {label}
       <input
         type="file"
-        accept=".csv,.txt"
+        accept={accept}
         className="hidden"
         onChange={(e) => {
           const f = e.target.files?.[0];
@@ -243,7 +457,12 @@ function CompareBars({ a, b, titleA = "A", titleB = "B" }) {
 
 function Panel({ title, timeline, setTimeline, fileName, setFileName }) {
   const [pngRef] = useState({ current: null });
-  const derived = useMemo(() => deriveMetricsFromTimeline(timeline), [timeline]);
+  const [cpiStack, setCpiStack] = useState([]);
+  const [summary, setSummary] = useState(null);
+  const derived = useMemo(
+    () => (summary ? metricsFromSummary(summary) : deriveMetricsFromTimeline(timeline)),
+    [summary, timeline]
+  );
 
   return (
     <div className="flex flex-col gap-4">
@@ -251,7 +470,35 @@ function Panel({ title, timeline, setTimeline, fileName, setFileName }) {
         <FilePicker
           label="Load Timeline CSV"
           onName={setFileName}
-          onFile={(txt) => setTimeline(parseCSVText(txt))}
+          onFile={(txt) => {
+            setSummary(null);
+            setTimeline(parseCSVText(txt));
+          }}
+        />
+        <FilePicker
+          label="Load Summary JSON"
+          accept=".json"
+          onFile={(txt) => {
+            try {
+              const sum = JSON.parse(txt);
+              setSummary(sum);
+              setCpiStack(cpiStackFromSummary(sum));
+            } catch (e) {
+              alert("Not a summary file: " + e.message);
+            }
+          }}
+        />
+        <FilePicker
+          label="Load CPI Stack CSV"
+          onFile={(txt) => setCpiStack(parseCpiStack(parseCSVText(txt)))}
+        />
+        <LiveControls
+          setTimeline={(tl) => {
+            setSummary(null);
+            setTimeline(tl);
+          }}
+          setFileName={setFileName}
+          setCpiStack={setCpiStack}
         />
         <button
           className="px-3 py-1.5 rounded-md bg-slate-800 border border-slate-600 hover:bg-slate-700 text-slate-100 shadow-sm"
@@ -266,16 +513,28 @@ function Panel({ title, timeline, setTimeline, fileName, setFileName }) {
         <StatCard title="Retired" value={derived.retired} />
         <StatCard title="CPI" value={derived.cpi ? derived.cpi.toFixed(2) : "-"} />
         <StatCard title="Total Stalls" value={derived.stalls.total} />
+        {summary && (
+          <>
+            <StatCard title="Predictor" value={summary.config?.predictor || "-"} />
+            <StatCard
+              title="BP Accuracy"
+              value={summary.metrics?.bp_predictions ? `${summary.metrics.bp_accuracy_pct.toFixed(1)}%` : "-"}
+            />
+          </>
+        )}
       </div>
 
+      <CpiStackChart series={cpiStack} />
+
       <TimelineGrid title={title} fileName={fileName} timeline={timeline} onExportPNGRef={pngRef} />
 
-      {timeline && (
+      {(timeline || summary) && (
         <div className="grid grid-cols-2 md:grid-cols-4 gap-3">
           <StatCard title="RAW stalls" value={derived.stalls.raw} />
           <StatCard title="WAR stalls" value={derived.stalls.war} />
           <StatCard title="WAW stalls" value={derived.stalls.waw} />
           <StatCard title="CTRL stalls" value={derived.stalls.ctrl} />
+          <StatCard title="MEM stalls" value={derived.stalls.mem} note="store buffer, partial overlap, D-cache / dTLB miss" />
         </div>
       )}
     </div>